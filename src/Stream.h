@@ -9,6 +9,7 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 
 // Array values
 #define startA (0.1)
@@ -16,6 +17,46 @@
 #define startC (0.0)
 #define startScalar (0.4)
 
+// Order in which copy and triad visit the elements when given to set_access_order.
+// Every order still visits each element exactly once.
+struct AccessOrder
+{
+  enum Kind {Strided, Reverse, Blocks};
+  Kind kind;
+  // Strided: elements 0, stride, 2*stride, ..., then 1, 1+stride, ... and so on
+  int stride;
+  // Blocks: the first element of each block of block_size elements, in the order the blocks are
+  // visited; the elements inside a block are visited in order
+  int block_size;
+  std::vector<intptr_t> blocks;
+};
+
+// Loop schedule given to set_schedule: the OpenMP schedule kinds, or a taskloop over chunks.
+// A chunk of 0 leaves the chunk size to the implementation.
+struct LoopSchedule
+{
+  enum Kind {Static, Dynamic, Guided, Taskloop};
+  Kind kind;
+  int chunk;
+};
+
+// What one worker thread did in a kernel call, recorded in instrumented mode: when it started
+// and finished its share, in timer_ticks() from tsc.h, and the number of elements in the share
+struct ThreadTiming
+{
+  uint64_t start;
+  uint64_t end;
+  size_t elements;
+};
+
+// Read-only view of the active elements of one array, in memory the host can read in place
+template <class T>
+struct HostArray
+{
+  const T *data;
+  intptr_t size;
+};
+
 template <class T>
 class Stream
 {
@@ -36,6 +77,71 @@ class Stream
     virtual void init_arrays(T initA, T initB, T initC) = 0;
     virtual void read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) = 0;
 
+    // Optional: restrict all kernels, init_arrays and read_arrays to the first n elements
+    // of the arrays, where n is no larger than the size given at construction.
+    // This lets the driver sweep array sizes without reallocating; returns false if unsupported.
+    virtual bool set_active_size(const intptr_t n) { return false; }
+
+    // Optional: make copy, mul, add, triad and nstream write their results with non-temporal
+    // (streaming) stores, bypassing the caches; returns false if unsupported.
+    virtual bool set_nontemporal(const bool enable) { return false; }
+
+    // Optional: make copy and triad visit the elements in the given order instead of sequentially,
+    // or sequentially again if order is null. The order is not copied and must outlive its use.
+    // Returns false if unsupported.
+    virtual bool set_access_order(const AccessOrder *order) { return false; }
+
+    // Optional: distribute the iterations of copy, mul, add, triad, nstream, dot, gather and
+    // scatter over the threads with the given schedule; returns false if unsupported.
+    virtual bool set_schedule(const LoopSchedule& schedule) { return false; }
+
+    // Optional: instrumented mode, in which copy, mul, add, triad and dot record what each worker
+    // thread did, returned by thread_timings for the last call of one of them, indexed by thread.
+    // Threads that took no part have no elements. Returns false if unsupported.
+    virtual bool set_instrumented(const bool enable) { return false; }
+    virtual std::vector<ThreadTiming> thread_timings() { return std::vector<ThreadTiming>(); }
+
+    // Optional: cache-resident mode, for arrays small enough that starting a parallel region and
+    // reading the clock would dominate a single pass. Each call of copy, mul, add, triad and dot
+    // runs its loop the given number of times within one parallel region, with every thread over
+    // the same part of the arrays each time and a barrier in between, and times the repetitions
+    // with timer_ticks() from tsc.h. Zero turns the mode off; returns false if unsupported.
+    virtual bool set_repeats(const int repeats) { return false; }
+    // Ticks taken by the repetitions of the last kernel call in cache-resident mode
+    virtual uint64_t repeat_ticks() { return 0; }
+
+    // Optional: run copy, mul, add, triad and dot the given number of times inside a single
+    // parallel region, separated by barriers instead of a fork and join per kernel. Appends the
+    // seconds of each call, from the first thread starting it to the last finishing it, to
+    // timings[0] to timings[4], and stores the result of the last dot in sum.
+    // Returns false if unsupported.
+    virtual bool run_persistent(const unsigned int iterations, std::vector<std::vector<double>>& timings, T& sum)
+    {
+      return false;
+    }
+
+    // Optional: gather (a[i] = b[idx[i]]) and scatter (a[idx[i]] = b[i]) over the active elements,
+    // through the index array last given to set_indices, which holds one index per active element.
+    // set_indices returns false if unsupported, in which case gather and scatter are never called.
+    virtual bool set_indices(const std::vector<int>& indices) { return false; }
+    virtual void gather() {}
+    virtual void scatter() {}
+
+    // Optional: the mean absolute error of the active elements of a, b and c against the given
+    // values, taking every stride'th element, computed where the arrays are without copying them
+    // to the host. Returns false if unsupported, in which case the driver reads them back.
+    virtual bool verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                        double& errA, double& errB, double& errC) { return false; }
+
+    // Optional: copies a.size() elements of each array, starting at element begin, to the host.
+    // Returns false if unsupported, in which case the driver reads whole arrays with read_arrays.
+    virtual bool read_range(const intptr_t begin, std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) { return false; }
+
+    // Optional: views of the active elements of a, b and c, for implementations whose arrays are in
+    // host memory, so the driver can read them without a copy. Returns false if the arrays are
+    // elsewhere, in which case the driver reads them back.
+    virtual bool host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c) { return false; }
+
 };
 
 
@@ -43,4 +149,9 @@ class Stream
 void listDevices(void);
 std::string getDeviceName(const int);
 std::string getDeviceDriver(const int);
+// Memory that the arrays are allocated from on the given device, for --arraysize auto and mem:PCT:
+// the bytes available and the size of the last-level cache in front of them. Returns false if the
+// arrays are in host memory, which the driver finds from the host topology instead; a device that
+// cannot report its memory returns true with both set to zero.
+bool getDeviceMemory(const int, size_t& memory, size_t& cache);
 
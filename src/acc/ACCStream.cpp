@@ -189,5 +189,13 @@ std::string getDeviceDriver(const int)
 {
   return std::string("Device driver unavailable");
 }
+
+bool getDeviceMemory(const int, size_t& memory, size_t& cache)
+{
+  if (acc_get_device_type() == acc_device_host)
+    return false;
+  memory = cache = 0;
+  return true;
+}
 template class ACCStream<float>;
 template class ACCStream<double>;
@@ -0,0 +1,132 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+
+#include "sysfs.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+// Thread count and pinning selected with --threads and --bind.
+// The driver turns this into one CPU per worker thread and applies it with whatever the
+// compiled implementation offers; worker_cpus records where each worker actually ended up.
+struct AffinityConfig
+{
+  // Number of worker threads, or 0 to leave it to the implementation
+  int threads = 0;
+  // compact, spread or an explicit CPU list such as "0-3,8"; empty to leave threads unpinned
+  std::string bind;
+  // CPUs of each worker after pinning, for the results
+  std::vector<std::vector<int>> worker_cpus;
+  // CPUs the process could run on before the workers were pinned
+  std::vector<int> process_cpus;
+};
+
+inline AffinityConfig& affinity_config()
+{
+  static AffinityConfig config;
+  return config;
+}
+
+// CPUs the calling thread may run on
+inline std::vector<int> current_cpus()
+{
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t mask;
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      if (CPU_ISSET(cpu, &mask))
+        cpus.push_back(cpu);
+#endif
+  return cpus;
+}
+
+// Restricts the calling thread to the given CPUs; new threads it creates inherit them
+inline bool pin_current_thread(const std::vector<int>& cpus)
+{
+#if defined(__linux__)
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int cpu : cpus)
+    if (cpu >= 0 && cpu < CPU_SETSIZE)
+      CPU_SET(cpu, &mask);
+  return sched_setaffinity(0, sizeof(mask), &mask) == 0;
+#else
+  return false;
+#endif
+}
+
+// The CPUs of allowed ordered so that hardware threads of a core are adjacent, then the cores
+// of a package, then the packages, using the topology in sysfs
+inline std::vector<int> order_cpus_compact(std::vector<int> allowed)
+{
+  std::vector<std::tuple<int, int, int>> keyed;
+  for (int cpu : allowed)
+  {
+    std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+    std::string package = read_sysfs_line(topology + "physical_package_id");
+    std::string core = read_sysfs_line(topology + "core_id");
+    keyed.push_back(std::make_tuple(package.empty() ? 0 : std::stoi(package),
+                                    core.empty() ? cpu : std::stoi(core), cpu));
+  }
+  std::sort(keyed.begin(), keyed.end());
+  for (size_t i = 0; i < keyed.size(); i++)
+    allowed[i] = std::get<2>(keyed[i]);
+  return allowed;
+}
+
+// One CPU for each of the given number of workers:
+// - compact: consecutive hardware threads, filling a core and then a package before the next
+// - spread:  evenly spaced over the allowed CPUs in compact order, so across cores and packages
+// - a list:  the listed CPUs in order, reused round-robin if there are more workers than CPUs
+// Returns an empty plan and sets error if the binding cannot be satisfied.
+inline std::vector<int> plan_affinity(const std::string& bind, int workers, const std::vector<int>& allowed,
+                                      std::string& error)
+{
+  std::vector<int> plan;
+  if (bind == "compact" || bind == "spread")
+  {
+    std::vector<int> order = order_cpus_compact(allowed);
+    if (order.empty())
+    {
+      error = "the allowed CPUs of this process are not known";
+      return plan;
+    }
+    if (workers > static_cast<int>(order.size()))
+    {
+      error = "more threads than the " + std::to_string(order.size()) + " allowed CPUs";
+      return plan;
+    }
+    for (int i = 0; i < workers; i++)
+      plan.push_back(bind == "compact" ? order[i] : order[static_cast<size_t>(i) * order.size() / workers]);
+  }
+  else
+  {
+    std::vector<int> list;
+    if (!parse_id_list(bind, list) || list.empty())
+    {
+      error = "invalid CPU list " + bind;
+      return plan;
+    }
+    for (int cpu : list)
+      if (std::find(allowed.begin(), allowed.end(), cpu) == allowed.end())
+      {
+        error = "CPU " + std::to_string(cpu) + " is not available to this process";
+        return plan;
+      }
+    for (int i = 0; i < workers; i++)
+      plan.push_back(list[i % list.size()]);
+  }
+  return plan;
+}
@@ -63,6 +63,10 @@ run_build() {
 
   local bin="./$build/$model_lower-stream"
   local installed_bin="./$install_dir/bin/$model_lower-stream"
+  if [[ "$flags" == *"-DPLUGIN=ON"* ]]; then
+    bin="$bin.so"
+    installed_bin="./$install_dir/lib/$model_lower-stream.so"
+  fi
 
   echo "Checking for final executable: $bin"
   if [[ -f "$bin" ]]; then
@@ -146,6 +150,9 @@ build_gcc() {
     "./$BUILD_DIR/omp_$name/omp-stream" -s 1048576 -n 10
   fi
 
+  run_build $name "${GCC_CXX:?}" simd "$cxx"
+  run_build "${name}_plugin" "${GCC_CXX:?}" omp "$cxx -DPLUGIN=ON"
+
   for use_onedpl in OFF OPENMP TBB; do
     case "$use_onedpl" in
       OFF) dpl_conditional_flags="-DCXX_EXTRA_LIBRARIES=${GCC_STD_PAR_LIB:-}"  ;;
@@ -221,6 +228,7 @@ build_clang() {
   local name="clang_build"
   local cxx="-DCMAKE_CXX_COMPILER=${CLANG_CXX:?}"
   run_build $name "${CLANG_CXX:?}" omp "$cxx"
+  run_build $name "${CLANG_CXX:?}" simd "$cxx"
 
   if [ "${CLANG_OMP_OFFLOAD_AMD:-false}" != "false" ]; then
     run_build "amd_$name" "${GCC_CXX:?}" omp "$cxx -DOFFLOAD=AMD:$AMD_ARCH"
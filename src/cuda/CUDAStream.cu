@@ -50,6 +50,7 @@ CUDAStream<T>::CUDAStream(const int ARRAY_SIZE, const int device_index)
   std::cout << "Memory: DEFAULT" << std::endl;
 #endif
   array_size = ARRAY_SIZE;
+  alloc_size = ARRAY_SIZE;
 
 
   // Query device for sensible dot kernel block count
@@ -161,6 +162,39 @@ void CUDAStream<T>::read_arrays(std::vector<T>& a, std::vector<T>& b, std::vecto
 #endif
 }
 
+template <class T>
+bool CUDAStream<T>::read_range(const intptr_t begin, std::vector<T>& a, std::vector<T>& b, std::vector<T>& c)
+{
+  // Copy part of device memory to host
+#if defined(PAGEFAULT) || defined(MANAGED)
+  cudaDeviceSynchronize();
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    a[i] = d_a[begin + i];
+    b[i] = d_b[begin + i];
+    c[i] = d_c[begin + i];
+  }
+#else
+  cudaMemcpy(a.data(), d_a + begin, a.size()*sizeof(T), cudaMemcpyDeviceToHost);
+  check_error();
+  cudaMemcpy(b.data(), d_b + begin, b.size()*sizeof(T), cudaMemcpyDeviceToHost);
+  check_error();
+  cudaMemcpy(c.data(), d_c + begin, c.size()*sizeof(T), cudaMemcpyDeviceToHost);
+  check_error();
+#endif
+  return true;
+}
+
+
+template <class T>
+bool CUDAStream<T>::set_active_size(const intptr_t n)
+{
+  // The array size must be divisible by TBSIZE for kernel launches
+  if (n > alloc_size || n % TBSIZE != 0)
+    return false;
+  array_size = n;
+  return true;
+}
 
 template <typename T>
 __global__ void copy_kernel(const T * a, T * c)
@@ -341,5 +375,20 @@ std::string getDeviceDriver(const int device)
   return std::to_string(driver);
 }
 
+
+bool getDeviceMemory(const int device, size_t& memory, size_t& cache)
+{
+  cudaSetDevice(device);
+  check_error();
+  size_t total;
+  cudaMemGetInfo(&memory, &total);
+  check_error();
+  cudaDeviceProp props;
+  cudaGetDeviceProperties(&props, device);
+  check_error();
+  cache = props.l2CacheSize;
+  return true;
+}
+
 template class CUDAStream<float>;
 template class CUDAStream<double>;
@@ -21,8 +21,9 @@ template <class T>
 class CUDAStream : public Stream<T>
 {
   protected:
-    // Size of arrays
+    // Size of arrays, and the number of elements actually allocated
     int array_size;
+    int alloc_size;
 
     // Host array for partial sums for dot kernel
     T *sums;
@@ -50,5 +51,8 @@ class CUDAStream : public Stream<T>
 
     virtual void init_arrays(T initA, T initB, T initC) override;
     virtual void read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
+    virtual bool read_range(const intptr_t begin, std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
+
+    virtual bool set_active_size(const intptr_t n) override;
 
 };
@@ -66,11 +66,19 @@ template <typename T> T *alloc_raw(size_t size) { return cl::sycl::malloc_shared
 template <typename T> void dealloc_raw(T *ptr) { cl::sycl::free(ptr, queue); }
 
 #else
+#include "host_alloc.h"
+
+// Host memory, placed according to the NUMA policy
 template<typename T>
-T *alloc_raw(size_t size) { return (T *) aligned_alloc(ALIGNMENT, sizeof(T) * size); }
+T *alloc_raw(size_t size) { return host_alloc<T>(size); }
 
 template<typename T>
-void dealloc_raw(T *ptr) { free(ptr); }
+void dealloc_raw(T *ptr) { host_free(ptr); }
+
+// Unless nvc++ makes the heap GPU memory, the arrays stay in host memory
+#if !defined(_NVHPC_STDPAR_GPU)
+#define STD_HOST_ARRAYS
+#endif
 #endif
 
 #endif
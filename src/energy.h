@@ -0,0 +1,208 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "sysfs.h"
+
+// Energy of the CPU packages and their DRAM, read around each kernel from the RAPL counters that
+// Linux exposes through powercap as /sys/class/powercap/intel-rapl:*, which is also where it puts
+// those of AMD processors. Only the package and dram zones are read; the core and uncore zones
+// are part of the package. The counters are in microjoules, wrap at max_energy_range_uj and are
+// updated about every millisecond, so a single short kernel is measured coarsely but the mean
+// over many calls is not. Recent kernels make energy_uj readable by root only, and any zone that
+// cannot be read is left out.
+class EnergyCounters
+{
+  public:
+    EnergyCounters(size_t kernels, const std::string& root = "/sys/class/powercap")
+      : totals(kernels), seconds(kernels, 0.0), calls(kernels, 0)
+    {
+#if defined(__linux__)
+      open_domains(root);
+#endif
+      for (std::vector<double>& t : totals)
+        t.assign(domains.size(), 0.0);
+      before.assign(domains.size(), 0.0);
+    }
+
+    ~EnergyCounters()
+    {
+#if defined(__linux__)
+      for (const Domain& d : domains)
+        close(d.fd);
+#endif
+    }
+
+    EnergyCounters(const EnergyCounters&) = delete;
+    EnergyCounters& operator=(const EnergyCounters&) = delete;
+
+    bool available() const { return !domains.empty(); }
+
+    // Names of the domains, package-N and dram-N, in the order of the values returned by average()
+    std::vector<std::string> names() const
+    {
+      std::vector<std::string> result;
+      for (const Domain& d : domains)
+        result.push_back(d.name);
+      return result;
+    }
+
+    // Number of kernels the energy is kept for
+    size_t kernels() const { return calls.size(); }
+
+    // Call immediately before and after the timed region of a kernel call
+    void start()
+    {
+      read(before);
+      started = std::chrono::steady_clock::now();
+    }
+
+    void stop(size_t kernel)
+    {
+      auto stopped = std::chrono::steady_clock::now();
+      std::vector<double> after;
+      read(after);
+      for (size_t i = 0; i < domains.size(); i++)
+      {
+        double microjoules = after[i] - before[i];
+        if (microjoules < 0.0)
+          microjoules += domains[i].range;
+        totals[kernel][i] += microjoules * 1.0E-6;
+      }
+      seconds[kernel] += std::chrono::duration_cast<std::chrono::duration<double> >(stopped - started).count();
+      calls[kernel]++;
+    }
+
+    // Mean joules per call of the given kernel in each domain
+    std::vector<double> average(size_t kernel) const
+    {
+      std::vector<double> result(domains.size(), 0.0);
+      if (calls[kernel])
+        for (size_t i = 0; i < domains.size(); i++)
+          result[i] = totals[kernel][i] / calls[kernel];
+      return result;
+    }
+
+    // Mean joules per call of the given kernel over all the domains
+    double joules(size_t kernel) const
+    {
+      std::vector<double> values = average(kernel);
+      double sum = 0.0;
+      for (double v : values)
+        sum += v;
+      return sum;
+    }
+
+    // Mean power over the calls of the given kernel, over all the domains
+    double watts(size_t kernel) const
+    {
+      return seconds[kernel] > 0.0 ? joules(kernel) * calls[kernel] / seconds[kernel] : 0.0;
+    }
+
+    // Reason no domains are available, if any
+    const std::string& error() const { return last_error; }
+
+  private:
+    struct Domain
+    {
+      std::string name;
+      int fd;
+      // Microjoules at which the counter wraps to zero
+      double range;
+    };
+
+    std::vector<Domain> domains;
+    std::vector<std::vector<double>> totals;
+    std::vector<double> seconds;
+    std::vector<size_t> calls;
+    std::vector<double> before;
+    std::chrono::steady_clock::time_point started;
+    std::string last_error;
+
+#if defined(__linux__)
+    // Zones are named intel-rapl:P for package P and intel-rapl:P:S for its subzones; the
+    // intel-rapl-mmio zones duplicate the package ones on some processors and are not read
+    void open_domains(const std::string& root)
+    {
+      DIR *dir = opendir(root.c_str());
+      if (!dir)
+      {
+        last_error = root + " not found";
+        return;
+      }
+      std::vector<std::string> zones;
+      while (struct dirent *entry = readdir(dir))
+        if (!strncmp(entry->d_name, "intel-rapl:", 11))
+          zones.push_back(entry->d_name);
+      closedir(dir);
+      std::sort(zones.begin(), zones.end());
+
+      last_error = "no package or dram zones";
+      for (const std::string& zone : zones)
+      {
+        const std::string path = root + "/" + zone + "/";
+        const std::string name = read_sysfs_line(path + "name");
+        const std::string package = zone.substr(11, zone.find(':', 11) - 11);
+        Domain domain;
+        if (!name.compare(0, 8, "package-"))
+          domain.name = name;
+        else if (name == "dram")
+          domain.name = "dram-" + package;
+        else
+          continue;
+
+        domain.fd = open((path + "energy_uj").c_str(), O_RDONLY);
+        if (domain.fd < 0)
+        {
+          last_error = path + "energy_uj: " + strerror(errno);
+          continue;
+        }
+        char value[32];
+        if (pread(domain.fd, value, sizeof(value) - 1, 0) <= 0)
+        {
+          last_error = path + "energy_uj: " + strerror(errno);
+          close(domain.fd);
+          continue;
+        }
+        domain.range = strtod(read_sysfs_line(path + "max_energy_range_uj").c_str(), nullptr);
+        domains.push_back(domain);
+      }
+    }
+#endif
+
+    // Sysfs attributes are regenerated on every read from the start of the file
+    void read(std::vector<double>& values) const
+    {
+      values.assign(domains.size(), 0.0);
+#if defined(__linux__)
+      for (size_t i = 0; i < domains.size(); i++)
+      {
+        char value[32];
+        ssize_t length = pread(domains[i].fd, value, sizeof(value) - 1, 0);
+        if (length > 0)
+        {
+          value[length] = '\0';
+          values[i] = strtod(value, nullptr);
+        }
+      }
+#endif
+    }
+};
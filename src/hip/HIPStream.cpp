@@ -153,6 +153,29 @@ void HIPStream<T>::read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector
 #endif
 }
 
+template <class T>
+bool HIPStream<T>::read_range(const intptr_t begin, std::vector<T>& a, std::vector<T>& b, std::vector<T>& c)
+{
+  // Copy part of device memory to host
+#if defined(PAGEFAULT) || defined(MANAGED)
+  hipDeviceSynchronize();
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    a[i] = d_a[begin + i];
+    b[i] = d_b[begin + i];
+    c[i] = d_c[begin + i];
+  }
+#else
+  hipMemcpy(a.data(), d_a + begin, a.size()*sizeof(T), hipMemcpyDeviceToHost);
+  check_error();
+  hipMemcpy(b.data(), d_b + begin, b.size()*sizeof(T), hipMemcpyDeviceToHost);
+  check_error();
+  hipMemcpy(c.data(), d_c + begin, c.size()*sizeof(T), hipMemcpyDeviceToHost);
+  check_error();
+#endif
+  return true;
+}
+
 template <typename T>
 __global__ void copy_kernel(const T * a, T * c)
 {
@@ -320,5 +343,20 @@ std::string getDeviceDriver(const int device)
   return std::to_string(driver);
 }
 
+
+bool getDeviceMemory(const int device, size_t& memory, size_t& cache)
+{
+  hipSetDevice(device);
+  check_error();
+  size_t total;
+  hipMemGetInfo(&memory, &total);
+  check_error();
+  hipDeviceProp_t props;
+  hipGetDeviceProperties(&props, device);
+  check_error();
+  cache = props.l2CacheSize;
+  return true;
+}
+
 template class HIPStream<float>;
 template class HIPStream<double>;
@@ -63,5 +63,6 @@ class HIPStream : public Stream<T>
 
     virtual void init_arrays(T initA, T initB, T initC) override;
     virtual void read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
+    virtual bool read_range(const intptr_t begin, std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
 
 };
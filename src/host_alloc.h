@@ -0,0 +1,402 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+
+#include "sysfs.h"
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdint>
+#endif
+
+#ifndef ALIGNMENT
+#define ALIGNMENT (2*1024*1024) // 2MB
+#endif
+
+// Host memory for the CPU implementations, placed on NUMA nodes according to --numa.
+//
+// The policy is applied with mbind before the pages are first touched, so it holds
+// regardless of which threads run init_arrays:
+// - Default:    whatever the OS does, normally first touch.
+// - Local:      first touch, even if the process inherited another policy (e.g. from numactl);
+//               the implementations initialise the arrays in parallel with the same schedule
+//               as their kernels, so each thread's pages end up on its own node.
+// - Interleave: pages round-robin across all nodes.
+// - Bind:       all pages on a single node.
+// - Split:      each array cut into one contiguous block per node, in node order, which matches
+//               a static schedule when the threads are also ordered by node.
+// Every allocation is recorded so that the driver can report where the pages really are.
+enum class NumaPolicy {Default, Local, Interleave, Bind, Split};
+
+struct NumaConfig
+{
+  NumaPolicy policy = NumaPolicy::Default;
+  // Node for NumaPolicy::Bind
+  int node = 0;
+};
+
+inline NumaConfig& numa_config()
+{
+  static NumaConfig config;
+  return config;
+}
+
+// The pages backing host memory, selected with --pages:
+// - Default:   aligned_alloc, leaving huge pages to the transparent huge page (THP) defaults.
+// - Small:     base (normally 4K) pages only, with THP disabled for the arrays.
+// - THP:       transparent huge pages requested with madvise(MADV_HUGEPAGE).
+// - Hugetlb2M: explicit 2M pages from the hugetlb pool (/proc/sys/vm/nr_hugepages).
+// - Hugetlb1G: explicit 1G pages, which normally have to be reserved at boot.
+// With prefault, every page is faulted in at allocation, by the allocating thread.
+enum class PageBackend {Default, Small, THP, Hugetlb2M, Hugetlb1G};
+
+struct PageConfig
+{
+  PageBackend backend = PageBackend::Default;
+  bool prefault = false;
+};
+
+inline PageConfig& page_config()
+{
+  static PageConfig config;
+  return config;
+}
+
+inline std::string page_backend_name(PageBackend backend)
+{
+  switch (backend)
+  {
+    case PageBackend::Small:     return "4k";
+    case PageBackend::THP:       return "thp";
+    case PageBackend::Hugetlb2M: return "hugetlb-2m";
+    case PageBackend::Hugetlb1G: return "hugetlb-1g";
+    default:                     return "default";
+  }
+}
+
+struct HostAllocation
+{
+  void *ptr;
+  size_t bytes;
+  // Start and length of the mapping if the memory came from mmap rather than aligned_alloc
+  void *mapping;
+  size_t mapped;
+};
+
+inline std::vector<HostAllocation>& host_allocations()
+{
+  static std::vector<HostAllocation> allocations;
+  return allocations;
+}
+
+#if defined(__linux__)
+// Sets the policy of [addr, addr+bytes) to mode over the given nodes, moving any pages
+// already present; addr must be page aligned
+inline void numa_mbind(void *addr, size_t bytes, int mode, const std::vector<int>& nodes)
+{
+  const size_t bits = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> mask;
+  for (int n : nodes)
+  {
+    if (mask.size() <= static_cast<size_t>(n) / bits)
+      mask.resize(n / bits + 1, 0);
+    mask[n / bits] |= 1ul << (n % bits);
+  }
+  // The kernel reads one bit fewer than maxnode
+  unsigned long max_node = mask.empty() ? 0 : mask.size() * bits + 1;
+  if (syscall(SYS_mbind, addr, bytes, mode, mask.empty() ? nullptr : mask.data(), max_node, MPOL_MF_MOVE) != 0)
+    throw std::runtime_error(std::string("mbind failed: ") + strerror(errno));
+}
+#endif
+
+#if defined(__linux__)
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+// Maps at least bytes of anonymous memory for the given backend, aligned to its page size
+// (or ALIGNMENT, if larger); rounded is set to the usable length from the returned address
+inline void *map_pages(PageBackend backend, size_t bytes, size_t& rounded, HostAllocation& allocation)
+{
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  size_t page = sysconf(_SC_PAGESIZE);
+  if (backend == PageBackend::Hugetlb2M)
+  {
+    flags |= MAP_HUGETLB | MAP_HUGE_2MB;
+    page = 2ul << 20;
+  }
+  else if (backend == PageBackend::Hugetlb1G)
+  {
+    flags |= MAP_HUGETLB | MAP_HUGE_1GB;
+    page = 1ul << 30;
+  }
+  const size_t align = std::max<size_t>(page, ALIGNMENT);
+  rounded = (std::max<size_t>(bytes, 1) + align - 1) / align * align;
+
+  // hugetlb mappings are already aligned to their page size; otherwise over-allocate and trim
+  const bool hugetlb = flags & MAP_HUGETLB;
+  size_t length = hugetlb ? rounded : rounded + align;
+  void *mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mapping == MAP_FAILED)
+  {
+    if (hugetlb)
+      throw std::runtime_error("Failed to map " + std::to_string(rounded) + " bytes of " +
+                               page_backend_name(backend) + " pages: " + strerror(errno) +
+                               "; check the hugetlb pool in /sys/kernel/mm/hugepages");
+    throw std::runtime_error("Failed to map " + std::to_string(length) + " bytes of host memory: " + strerror(errno));
+  }
+
+  char *start = static_cast<char*>(mapping);
+  if (!hugetlb)
+  {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(mapping);
+    start = reinterpret_cast<char*>((addr + align - 1) / align * align);
+    size_t head = start - static_cast<char*>(mapping);
+    if (head)
+      munmap(mapping, head);
+    size_t tail = length - head - rounded;
+    if (tail)
+      munmap(start + rounded, tail);
+    mapping = start;
+    length = rounded;
+    madvise(start, rounded, backend == PageBackend::THP ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+  }
+  allocation.mapping = mapping;
+  allocation.mapped = length;
+  return start;
+}
+#endif
+
+inline void *host_alloc_bytes(size_t bytes)
+{
+  const PageConfig& pages = page_config();
+  HostAllocation allocation = {nullptr, bytes, nullptr, 0};
+  size_t rounded;
+  void *ptr;
+#if defined(__linux__)
+  if (pages.backend != PageBackend::Default)
+    ptr = map_pages(pages.backend, bytes, rounded, allocation);
+  else
+#endif
+  {
+    // aligned_alloc requires a multiple of the alignment
+    rounded = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    ptr = aligned_alloc(ALIGNMENT, rounded ? rounded : ALIGNMENT);
+    if (!ptr)
+      throw std::runtime_error("Failed to allocate " + std::to_string(bytes) + " bytes of host memory");
+  }
+  allocation.ptr = ptr;
+
+#if defined(__linux__)
+  const NumaConfig& config = numa_config();
+  std::vector<int> nodes = online_numa_nodes();
+  switch (config.policy)
+  {
+    case NumaPolicy::Default:
+      break;
+    case NumaPolicy::Local:
+      numa_mbind(ptr, rounded, MPOL_LOCAL, {});
+      break;
+    case NumaPolicy::Interleave:
+      numa_mbind(ptr, rounded, MPOL_INTERLEAVE, nodes);
+      break;
+    case NumaPolicy::Bind:
+      numa_mbind(ptr, rounded, MPOL_BIND, {config.node});
+      break;
+    case NumaPolicy::Split:
+    {
+      // Blocks are whole pages of the backend, which the alignment always is
+      const size_t page = (pages.backend == PageBackend::Hugetlb1G) ? (1ul << 30) : ALIGNMENT;
+      const size_t count = rounded / page;
+      for (size_t i = 0; i < nodes.size(); i++)
+      {
+        size_t first = count * i / nodes.size();
+        size_t last = count * (i + 1) / nodes.size();
+        if (last > first)
+          numa_mbind(static_cast<char*>(ptr) + first * page, (last - first) * page, MPOL_BIND, {nodes[i]});
+      }
+      break;
+    }
+  }
+
+  if (pages.prefault)
+  {
+    // Fault every page in now rather than in init_arrays; the touch loop is the fallback
+    // for kernels older than 5.14
+#if defined(MADV_POPULATE_WRITE)
+    if (madvise(ptr, rounded, MADV_POPULATE_WRITE) != 0)
+#endif
+    {
+      const size_t page = sysconf(_SC_PAGESIZE);
+      for (size_t offset = 0; offset < rounded; offset += page)
+        static_cast<volatile char*>(ptr)[offset] = 0;
+    }
+  }
+#endif
+
+  host_allocations().push_back(allocation);
+  return ptr;
+}
+
+template <typename T>
+T *host_alloc(size_t count)
+{
+  if (count > std::numeric_limits<size_t>::max() / sizeof(T))
+    throw std::runtime_error("Failed to allocate " + std::to_string(count) + " elements of host memory: "
+                             "the size in bytes overflows");
+  return static_cast<T*>(host_alloc_bytes(sizeof(T) * count));
+}
+
+inline void host_free(void *ptr)
+{
+  std::vector<HostAllocation>& allocations = host_allocations();
+  for (size_t i = 0; i < allocations.size(); i++)
+    if (allocations[i].ptr == ptr)
+    {
+#if defined(__linux__)
+      if (allocations[i].mapping)
+      {
+        munmap(allocations[i].mapping, allocations[i].mapped);
+        allocations.erase(allocations.begin() + i);
+        return;
+      }
+#endif
+      allocations.erase(allocations.begin() + i);
+      break;
+    }
+  free(ptr);
+}
+
+// Fraction of the sampled pages of an allocation found on each node, indexed by node number.
+// Pages not yet touched, or whose node cannot be determined, count towards none of them.
+inline std::vector<double> numa_placement(const HostAllocation& allocation, size_t samples = 4096)
+{
+  std::vector<double> fraction;
+#if defined(__linux__)
+  const size_t page = sysconf(_SC_PAGESIZE);
+  const size_t pages = (allocation.bytes + page - 1) / page;
+  if (pages == 0)
+    return fraction;
+  samples = std::min(samples, pages);
+
+  // Evenly spaced pages; move_pages with no target nodes only queries them
+  std::vector<void*> addrs(samples);
+  std::vector<int> status(samples, -1);
+  for (size_t i = 0; i < samples; i++)
+    addrs[i] = static_cast<char*>(allocation.ptr) + (pages * i / samples) * page;
+  if (syscall(SYS_move_pages, 0, samples, addrs.data(), nullptr, status.data(), 0) != 0)
+    return fraction;
+
+  for (int node : status)
+  {
+    if (node < 0)
+      continue;
+    if (static_cast<size_t>(node) >= fraction.size())
+      fraction.resize(node + 1, 0.0);
+    fraction[node] += 1.0;
+  }
+  for (double& f : fraction)
+    f /= samples;
+#endif
+  return fraction;
+}
+
+inline std::string numa_policy_name(NumaPolicy policy)
+{
+  switch (policy)
+  {
+    case NumaPolicy::Local:      return "local";
+    case NumaPolicy::Interleave: return "interleave";
+    case NumaPolicy::Bind:       return "bind:" + std::to_string(numa_config().node);
+    case NumaPolicy::Split:      return "split";
+    default:                     return "default";
+  }
+}
+
+// Memory backing the host arrays according to /proc/self/smaps, in kB
+struct PageUsage
+{
+  // Resident memory of the mappings holding the arrays
+  size_t resident;
+  // Of which transparent huge pages
+  size_t thp;
+  // Of which explicit hugetlb pages
+  size_t hugetlb;
+  // Largest page size used by these mappings
+  size_t page_size;
+};
+
+// Sums every mapping that overlaps a host array, each once even if it holds several arrays.
+// Mappings can be larger than the arrays (e.g. aligned_alloc's own bookkeeping), so this is an
+// upper bound on the memory of the arrays themselves.
+inline bool host_page_usage(PageUsage& usage)
+{
+  usage = PageUsage{0, 0, 0, 0};
+#if defined(__linux__)
+  const std::vector<HostAllocation>& allocations = host_allocations();
+  if (allocations.empty())
+    return false;
+
+  FILE *smaps = fopen("/proc/self/smaps", "r");
+  if (!smaps)
+    return false;
+
+  char line[512];
+  bool overlaps = false;
+  while (fgets(line, sizeof(line), smaps))
+  {
+    unsigned long start, end;
+    char name[64];
+    size_t kb;
+    if (sscanf(line, "%lx-%lx ", &start, &end) == 2)
+    {
+      overlaps = false;
+      for (const HostAllocation& a : allocations)
+      {
+        uintptr_t first = reinterpret_cast<uintptr_t>(a.ptr);
+        if (first < end && first + a.bytes > start)
+          overlaps = true;
+      }
+    }
+    else if (overlaps && sscanf(line, "%63[^:]: %zu kB", name, &kb) == 2)
+    {
+      std::string field = name;
+      if (field == "Rss")
+        usage.resident += kb;
+      else if (field == "AnonHugePages")
+        usage.thp += kb;
+      else if (field == "Private_Hugetlb" || field == "Shared_Hugetlb")
+        usage.hugetlb += kb;
+      else if (field == "KernelPageSize")
+        usage.page_size = std::max(usage.page_size, kb);
+    }
+  }
+  fclose(smaps);
+  // Rss does not include hugetlb pages
+  usage.resident += usage.hugetlb;
+  return true;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <random>
+#include <algorithm>
+
+// Order in which the gather and scatter kernels visit the elements through their index array.
+// Every pattern is a permutation, so scatter writes each element exactly once.
+// - Identity: idx[i] = i, the same accesses as the unit-stride kernels
+// - Stride:   every parameter'th element, then the same again starting from 1, 2, ...
+// - Block:    blocks of parameter consecutive elements, with the blocks in random order
+// - Random:   a uniformly random permutation
+enum class IndexPattern {Identity, Stride, Block, Random};
+
+struct IndexConfig
+{
+  IndexPattern pattern = IndexPattern::Identity;
+  int parameter = 0;
+};
+
+inline std::string index_pattern_name(const IndexConfig& config)
+{
+  switch (config.pattern)
+  {
+    case IndexPattern::Stride: return "stride:" + std::to_string(config.parameter);
+    case IndexPattern::Block:  return "block:" + std::to_string(config.parameter);
+    case IndexPattern::Random: return "random";
+    default:                   return "identity";
+  }
+}
+
+// The indices of n elements in the given pattern; the shuffles are seeded so runs are repeatable
+inline std::vector<int> make_indices(const IndexConfig& config, int n, unsigned int seed = 42)
+{
+  std::vector<int> indices(n);
+  std::mt19937_64 rng(seed);
+  switch (config.pattern)
+  {
+    case IndexPattern::Stride:
+    {
+      size_t i = 0;
+      for (int start = 0; start < config.parameter && start < n; start++)
+        for (int j = start; j < n; j += config.parameter)
+          indices[i++] = j;
+      break;
+    }
+    case IndexPattern::Block:
+    {
+      int blocks = (n + config.parameter - 1) / config.parameter;
+      std::vector<int> order(blocks);
+      std::iota(order.begin(), order.end(), 0);
+      std::shuffle(order.begin(), order.end(), rng);
+      size_t i = 0;
+      for (int block : order)
+        for (int j = block * config.parameter; j < std::min(n, (block + 1) * config.parameter); j++)
+          indices[i++] = j;
+      break;
+    }
+    case IndexPattern::Random:
+      std::iota(indices.begin(), indices.end(), 0);
+      std::shuffle(indices.begin(), indices.end(), rng);
+      break;
+    default:
+      std::iota(indices.begin(), indices.end(), 0);
+      break;
+  }
+  return indices;
+}
+
+// Cache lines the indirect side of a gather or scatter moves when only consecutive accesses to
+// the same line share it, for elements of the given size in a line-aligned array
+inline size_t indirect_lines(const std::vector<int>& indices, size_t element_size, size_t line_size = 64)
+{
+  size_t lines = 0;
+  size_t previous = 0;
+  for (size_t i = 0; i < indices.size(); i++)
+  {
+    size_t line = indices[i] * element_size / line_size;
+    if (i == 0 || line != previous)
+      lines++;
+    previous = line;
+  }
+  return lines;
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdio>
+
+// Minimal streaming JSON writer, just enough for the driver's results file.
+// Objects and arrays are written as they are opened; commas and indentation are handled here.
+class JsonWriter
+{
+  public:
+    explicit JsonWriter(std::ostream& out) : out(out), after_key(false) {}
+
+    void begin_object() { open('{'); }
+    void end_object() { close('}'); }
+    void begin_array() { open('['); }
+    void end_array() { close(']'); }
+
+    void key(const std::string& name)
+    {
+      separate();
+      write_string(name);
+      out << ": ";
+      after_key = true;
+    }
+
+    void value(const std::string& v) { separate(); write_string(v); }
+    void value(const char *v) { value(std::string(v)); }
+    void value(bool v) { separate(); out << (v ? "true" : "false"); }
+    void value(int v) { separate(); out << v; }
+    void value(unsigned int v) { separate(); out << v; }
+    void value(long v) { separate(); out << v; }
+    void value(unsigned long v) { separate(); out << v; }
+    void value(long long v) { separate(); out << v; }
+    void value(unsigned long long v) { separate(); out << v; }
+    void value(double v)
+    {
+      separate();
+      // JSON has no representation for NaN or infinity
+      if (!std::isfinite(v))
+      {
+        out << "null";
+        return;
+      }
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%.*g", std::numeric_limits<double>::max_digits10, v);
+      out << buf;
+    }
+
+    template <typename V>
+    void field(const std::string& name, const V& v) { key(name); value(v); }
+
+    template <typename V>
+    void array(const std::string& name, const std::vector<V>& values)
+    {
+      key(name);
+      begin_array();
+      for (const V& v : values)
+        value(v);
+      end_array();
+    }
+
+  private:
+    std::ostream& out;
+    // One entry per open object/array, set once it has its first member
+    std::vector<bool> has_members;
+    bool after_key;
+
+    void newline()
+    {
+      out << '\n' << std::string(2 * has_members.size(), ' ');
+    }
+
+    // Emit the comma and indentation due before a key or a value
+    void separate()
+    {
+      if (after_key)
+      {
+        after_key = false;
+        return;
+      }
+      if (has_members.empty())
+        return;
+      if (has_members.back())
+        out << ',';
+      has_members.back() = true;
+      newline();
+    }
+
+    void open(char c)
+    {
+      separate();
+      out << c;
+      has_members.push_back(false);
+    }
+
+    void close(char c)
+    {
+      bool members = has_members.back();
+      has_members.pop_back();
+      if (members)
+        newline();
+      out << c;
+      if (has_members.empty())
+        out << '\n';
+    }
+
+    void write_string(const std::string& s)
+    {
+      out << '"';
+      for (char c : s)
+      {
+        switch (c)
+        {
+          case '"':  out << "\\\""; break;
+          case '\\': out << "\\\\"; break;
+          case '\n': out << "\\n"; break;
+          case '\r': out << "\\r"; break;
+          case '\t': out << "\\t"; break;
+          default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+              char buf[8];
+              snprintf(buf, sizeof(buf), "\\u%04x", c);
+              out << buf;
+            }
+            else
+              out << c;
+        }
+      }
+      out << '"';
+    }
+};
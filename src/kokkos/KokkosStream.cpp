@@ -10,7 +10,7 @@
 template <class T>
 KokkosStream<T>::KokkosStream(
         const int ARRAY_SIZE, const int device_index)
-    : array_size(ARRAY_SIZE)
+    : array_size(ARRAY_SIZE), alloc_size(ARRAY_SIZE)
 {
   Kokkos::initialize();
 
@@ -23,6 +23,7 @@ KokkosStream<T>::KokkosStream(
   *hm_a = create_mirror_view(*d_a);
   *hm_b = create_mirror_view(*d_b);
   *hm_c = create_mirror_view(*d_c);
+  d_idx = nullptr;
 }
 
 template <class T>
@@ -61,6 +62,73 @@ void KokkosStream<T>::read_arrays(
   }
 }
 
+template <class T>
+bool KokkosStream<T>::host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c)
+{
+  // Only where the views are in memory the host can read, as with the OpenMP and Serial backends
+  if (!Kokkos::SpaceAccessibility<Kokkos::HostSpace, typename Kokkos::View<T*>::memory_space>::accessible)
+    return false;
+  Kokkos::fence();
+  a = {d_a->data(), array_size};
+  b = {d_b->data(), array_size};
+  c = {d_c->data(), array_size};
+  return true;
+}
+
+template <class T>
+bool KokkosStream<T>::set_active_size(const intptr_t n)
+{
+  if (n > alloc_size)
+    return false;
+  array_size = n;
+  return true;
+}
+
+template <class T>
+bool KokkosStream<T>::set_indices(const std::vector<int>& indices)
+{
+  if (indices.size() > static_cast<size_t>(alloc_size))
+    return false;
+  if (!d_idx)
+    d_idx = new Kokkos::View<int*>(Kokkos::ViewAllocateWithoutInitializing("d_idx"), alloc_size);
+
+  typename Kokkos::View<int*>::HostMirror hm_idx = create_mirror_view(*d_idx);
+  for(size_t ii = 0; ii < indices.size(); ++ii)
+  {
+    hm_idx(ii) = indices[ii];
+  }
+  deep_copy(*d_idx, hm_idx);
+  return true;
+}
+
+template <class T>
+void KokkosStream<T>::gather()
+{
+  Kokkos::View<T*> a(*d_a);
+  Kokkos::View<T*> b(*d_b);
+  Kokkos::View<int*> idx(*d_idx);
+
+  Kokkos::parallel_for(array_size, KOKKOS_LAMBDA (const long index)
+  {
+    a[index] = b[idx[index]];
+  });
+  Kokkos::fence();
+}
+
+template <class T>
+void KokkosStream<T>::scatter()
+{
+  Kokkos::View<T*> a(*d_a);
+  Kokkos::View<T*> b(*d_b);
+  Kokkos::View<int*> idx(*d_idx);
+
+  Kokkos::parallel_for(array_size, KOKKOS_LAMBDA (const long index)
+  {
+    a[idx[index]] = b[index];
+  });
+  Kokkos::fence();
+}
+
 template <class T>
 void KokkosStream<T>::copy()
 {
@@ -168,5 +236,14 @@ std::string getDeviceDriver(const int device)
   return "Kokkos";
 }
 
+bool getDeviceMemory(const int, size_t& memory, size_t& cache)
+{
+  if (Kokkos::SpaceAccessibility<Kokkos::HostSpace, Kokkos::DefaultExecutionSpace::memory_space>::accessible)
+    return false;
+  // Kokkos has no portable query for the memory of a device
+  memory = cache = 0;
+  return true;
+}
+
 template class KokkosStream<float>;
 template class KokkosStream<double>;
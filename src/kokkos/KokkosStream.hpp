@@ -18,8 +18,9 @@ template <class T>
 class KokkosStream : public Stream<T>
 {
   protected:
-    // Size of arrays
+    // Size of arrays, and the number of elements actually allocated
     int array_size;
+    int alloc_size;
 
     // Device side pointers to arrays
      typename Kokkos::View<T*>* d_a;
@@ -29,6 +30,9 @@ class KokkosStream : public Stream<T>
      typename Kokkos::View<T*>::HostMirror* hm_b;
      typename Kokkos::View<T*>::HostMirror* hm_c;
 
+    // Index array for gather and scatter, allocated by the first set_indices
+     typename Kokkos::View<int*>* d_idx;
+
   public:
 
     KokkosStream(const int, const int);
@@ -44,5 +48,12 @@ class KokkosStream : public Stream<T>
     virtual void init_arrays(T initA, T initB, T initC) override;
     virtual void read_arrays(
             std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
+
+    virtual bool set_active_size(const intptr_t n) override;
+    virtual bool host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c) override;
+
+    virtual bool set_indices(const std::vector<int>& indices) override;
+    virtual void gather() override;
+    virtual void scatter() override;
 };
 
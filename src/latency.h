@@ -0,0 +1,153 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <numeric>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "host_alloc.h"
+#include "affinity.h"
+
+// A cyclic chain of pointers, one per cache line, through a host allocation of its own, which
+// goes through the same --numa and --pages placement as the arrays of the implementations.
+// The lines are visited in random order and each load takes its address from the previous one,
+// so neither out-of-order execution nor the hardware prefetchers can overlap the accesses and
+// the time per step is the load-to-use latency of wherever the chain fits.
+class PointerChain
+{
+  public:
+    static const size_t line_size = 64;
+
+    PointerChain(size_t bytes, unsigned int seed = 42)
+      : lines(std::max<size_t>(bytes / line_size, 2))
+    {
+      memory = static_cast<char *>(host_alloc_bytes(lines * line_size));
+
+      // Sattolo's algorithm: a random permutation that is a single cycle through every line,
+      // so the chain cannot fall into a shorter loop that fits in a smaller cache
+      std::vector<size_t> next(lines);
+      std::iota(next.begin(), next.end(), 0);
+      std::mt19937_64 rng(seed);
+      for (size_t i = lines - 1; i > 0; i--)
+      {
+        std::uniform_int_distribution<size_t> pick(0, i - 1);
+        std::swap(next[i], next[pick(rng)]);
+      }
+      for (size_t i = 0; i < lines; i++)
+        *reinterpret_cast<char **>(memory + i * line_size) = memory + next[i] * line_size;
+      position = memory;
+    }
+
+    ~PointerChain()
+    {
+      host_free(memory);
+    }
+
+    PointerChain(const PointerChain&) = delete;
+    PointerChain& operator=(const PointerChain&) = delete;
+
+    // Follows the chain for the given number of steps, carrying on from where the last call stopped
+    void chase(size_t steps)
+    {
+      char *p = position;
+      for (size_t i = 0; i < steps; i++)
+        p = *reinterpret_cast<char **>(p);
+      // Storing the end of the chain keeps the loads from being optimised away
+      position = p;
+    }
+
+    size_t bytes() const
+    {
+      return lines * line_size;
+    }
+
+  private:
+    size_t lines;
+    char *memory;
+    char *position;
+};
+
+// Chases a pointer chain on a thread of its own, pinned to one CPU, while the driver loads the
+// memory system from the other threads. The driver moves the probe through numbered phases,
+// and the probe keeps the time per access of each phase separately.
+class LatencyProbe
+{
+  public:
+    // Chain of the given size, built by the probe thread once pinned so that first touch puts it
+    // near the probe; a negative cpu leaves the probe unpinned
+    LatencyProbe(size_t bytes, int cpu, int phases)
+      : phase(-1), stopping(false), ready(false), seconds(phases, 0.0), accesses(phases, 0.0)
+    {
+      thread = std::thread([this, bytes, cpu]
+      {
+        if (cpu >= 0)
+          pin_current_thread({cpu});
+        PointerChain chain(bytes);
+        chain.chase(chain.bytes() / PointerChain::line_size);
+        ready = true;
+        while (!stopping)
+        {
+          // Short chunks, so little of the time is lost at the phase changes; a chunk that
+          // straddles a change is not counted
+          int p = phase;
+          auto t1 = std::chrono::high_resolution_clock::now();
+          chain.chase(chunk);
+          auto t2 = std::chrono::high_resolution_clock::now();
+          if (p >= 0 && p == phase)
+          {
+            seconds[p] += std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+            accesses[p] += chunk;
+          }
+        }
+      });
+      while (!ready)
+        std::this_thread::yield();
+    }
+
+    ~LatencyProbe()
+    {
+      stop();
+    }
+
+    LatencyProbe(const LatencyProbe&) = delete;
+    LatencyProbe& operator=(const LatencyProbe&) = delete;
+
+    // Accesses from now on are counted towards phase p, or not at all if p is negative
+    void set_phase(int p)
+    {
+      phase = p;
+    }
+
+    void stop()
+    {
+      stopping = true;
+      if (thread.joinable())
+        thread.join();
+    }
+
+    // Mean seconds per access during phase p, once the probe has stopped
+    double latency(int p) const
+    {
+      return accesses[p] > 0 ? seconds[p] / accesses[p] : 0.0;
+    }
+
+  private:
+    static const size_t chunk = 1024;
+
+    std::thread thread;
+    std::atomic<int> phase;
+    std::atomic<bool> stopping;
+    std::atomic<bool> ready;
+    std::vector<double> seconds;
+    std::vector<double> accesses;
+};
@@ -13,48 +13,57 @@
 #include <chrono>
 #include <algorithm>
 #include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <ctime>
 #include <cstring>
+#include <cerrno>
+#include <thread>
+#include <memory>
+#include <random>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <signal.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+#endif
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 #define VERSION_STRING "5.0"
 
 #include "Stream.h"
+#include "stats.h"
+#include "json.h"
+#include "perf_counters.h"
+#include "energy.h"
+#include "host_alloc.h"
+#include "affinity.h"
+#include "latency.h"
+#include "index_pattern.h"
+#include "tsc.h"
+#include "processes.h"
+#include "sysfs.h"
+
+#if defined(PLUGIN_DRIVER)
+#include "plugin.h"
+#include <dlfcn.h>
+#else
+#include "models.h"
+#endif
 
-#if defined(CUDA)
-#include "CUDAStream.h"
-#elif defined(STD_DATA)
-#include "STDDataStream.h"
-#elif defined(STD_INDICES)
-#include "STDIndicesStream.h"
-#elif defined(STD_RANGES)
-#include "STDRangesStream.hpp"
-#elif defined(TBB)
-#include "TBBStream.hpp"
-#elif defined(THRUST)
-#include "ThrustStream.h"
-#elif defined(HIP)
-#include "HIPStream.h"
-#elif defined(HC)
-#include "HCStream.h"
-#elif defined(OCL)
-#include "OCLStream.h"
-#elif defined(USE_RAJA)
-#include "RAJAStream.hpp"
-#elif defined(KOKKOS)
-#include "KokkosStream.hpp"
-#elif defined(ACC)
-#include "ACCStream.h"
-#elif defined(SYCL)
-#include "SYCLStream.h"
-#elif defined(SYCL2020)
-#include "SYCLStream2020.h"
-#elif defined(OMP)
-#include "OMPStream.h"
-#elif defined(FUTHARK)
-#include "FutharkStream.h"
+// Build configuration, defined by CMake
+#ifndef BUILD_COMPILER_STRING
+#define BUILD_COMPILER_STRING "unknown"
+#endif
+#ifndef BUILD_FLAGS_STRING
+#define BUILD_FLAGS_STRING "unknown"
 #endif
 
 // Default size of 2^25
-int ARRAY_SIZE = 33554432;
+intptr_t ARRAY_SIZE = 33554432;
 unsigned int num_times = 100;
 unsigned int deviceIndex = 0;
 bool use_float = false;
@@ -62,8 +71,162 @@ bool output_as_csv = false;
 bool mibibytes = false;
 std::string csv_separator = ",";
 
+// With --arraysize auto[:FACTOR] or mem:PCT, ARRAY_SIZE is chosen once the element size is known:
+// each array FACTOR times the last-level cache, but the three together never more than
+// auto_memory_fraction of the available memory, or the three arrays PCT percent of that memory
+enum class AutoSize {None, Cache, Memory};
+AutoSize auto_size = AutoSize::None;
+double auto_size_factor = 4.0;
+const double auto_memory_fraction = 0.5;
+const double max_memory_percent = 90.0;
+// How the size was chosen, for the output
+std::string array_size_choice;
+
+// Array sizes to sweep over with --sweep, in ascending order; empty if not sweeping
+std::vector<intptr_t> sweep_sizes;
+
+// Print percentiles and confidence intervals in addition to min/max/average
+bool output_stats = false;
+
+// With --until-stable, keep iterating past num_times until the 95% confidence interval of
+// every kernel's median runtime is within stable_ci_width of the median, or the budget runs out
+bool until_stable = false;
+double stable_ci_width = 0.01;
+double stable_time_budget = 60.0;
+// The runtimes are checked every stable_check_interval iterations at first, with the interval
+// doubling as the iterations grow so that there are 8 to 16 checks each time they double: the
+// checks then cost O(N log^2 N) in all rather than O(N^2). They bootstrap fewer resamples than
+// the final statistics.
+const unsigned int stable_check_interval = 10;
+const unsigned int stable_check_resamples = 200;
+
+// Results file for --json, which is written alongside the normal output
+std::string json_file;
+JsonWriter *json = nullptr;
+
+// With --nontemporal, the kernels are also timed with non-temporal stores
+bool nontemporal = false;
+
+// With --order, Copy and Triad are also timed visiting the elements in the order of access_order_kind:
+// every access_stride'th element, in reverse, or in blocks of access_block_bytes in random order
+bool use_access_order = false;
+AccessOrder::Kind access_order_kind = AccessOrder::Reverse;
+int access_stride = 1;
+intptr_t access_block_bytes = 4096;
+// The order for the current array size, while the kernels run
+const AccessOrder *access_order = nullptr;
+
+// With --cache-resident, each timed kernel call repeats the kernel this many times in one
+// parallel region, timed by the implementation with the fine-grained timer of tsc.h
+int cache_resident_repeats = 0;
+
+// With --persistent, the kernels are run again inside one parallel region for comparison
+bool persistent = false;
+
+// With --per-thread, what each worker thread did in every call of the five main kernels
+bool per_thread = false;
+std::vector<std::vector<std::vector<ThreadTiming>>> thread_records;
+
+// With --omp-schedule, the loop schedule of the kernels
+bool use_schedule = false;
+LoopSchedule loop_schedule = {LoopSchedule::Static, 0};
+
+// With --verify, how the arrays are checked after a run: every element, about verify_samples
+// elements of each array spread over it, or not at all
+enum class VerifyMode {Full, Sample, None};
+VerifyMode verify_mode = VerifyMode::Full;
+const intptr_t verify_samples = 1 << 20;
+// Elements of each array read back at a time when the implementation cannot check in place,
+// which with sampling are spread evenly over the arrays
+const intptr_t verify_chunk = 1 << 22;
+const intptr_t verify_sample_chunk = 4096;
+
+// With --perf, hardware counters are read around every timed kernel call
+bool use_perf = false;
+PerfCounters *perf = nullptr;
+
+// With --energy, the RAPL energy counters are read around every timed kernel call of the
+// default benchmark
+bool use_energy = false;
+EnergyCounters *energy = nullptr;
+
+// Steps of the pointer chain timed per sample with --latency: enough to time accurately when the
+// chain fits in L1, while a sample of a chain in DRAM still takes only tens of milliseconds
+const size_t latency_accesses = 1 << 18;
+
+// Kernel run by the workers with --loaded-latency: triad or copy
+std::string loaded_kernel = "triad";
+
+// Order of the indices of the gather and scatter kernels with --gather-scatter
+IndexConfig index_config;
+
+// With --scaling, the benchmark is run at every thread count from scaling_min to scaling_max
+int scaling_min = 0;
+int scaling_max = 0;
+
+// With --processes, the benchmark is run by this many forked worker processes at once, which
+// wait on process_group before each kernel
+int processes = 0;
+ProcessGroup *process_group = nullptr;
+
+// Set once the NUMA placement of the arrays of the current implementation has been printed
+bool placement_reported = false;
+
+// Best bandwidth in bytes per second of each kernel of the current implementation, labelled
+// with the array size when sweeping, for the comparison table of the plugin driver
+std::vector<std::pair<std::string, double>> best_bandwidths;
+
+#if defined(PLUGIN_DRIVER)
+// Implementations loaded with --plugin, and the one currently being run
+std::vector<const StreamPlugin *> plugins;
+std::vector<std::string> plugin_files;
+const StreamPlugin *current_plugin = nullptr;
+
+// With --fork, each implementation runs in a child process of its own
+bool fork_plugins = false;
+
+// With --list, the devices are listed once every plugin on the command line is loaded
+bool list_plugin_devices = false;
+#endif
+
+#if defined(TBB)
+// With --threads or --bind, the benchmark runs in this arena instead of TBB's default one
+tbb::task_arena *tbb_arena = nullptr;
+
+// Pins each thread joining the arena to the CPU planned for its slot
+class TBBPinningObserver : public tbb::task_scheduler_observer
+{
+  public:
+    TBBPinningObserver(tbb::task_arena& arena, const std::vector<int>& plan)
+      : tbb::task_scheduler_observer(arena), plan(plan) {}
+
+    void on_scheduler_entry(bool) override
+    {
+      int slot = tbb::this_task_arena::current_thread_index();
+      if (slot >= 0)
+        pin_current_thread({plan[slot % plan.size()]});
+    }
+
+  private:
+    std::vector<int> plan;
+};
+TBBPinningObserver *tbb_observer = nullptr;
+#endif
+
+// Outcome of checking the arrays after a run
+struct ArrayCheck
+{
+  // Mean absolute error of each array
+  long double errA, errB, errC;
+  // Whether the arrays were read back to the host rather than checked in place by the
+  // implementation, and the bytes and seconds that took
+  bool read_back;
+  double bytes;
+  double seconds;
+};
+
 template <typename T>
-void check_solution(const unsigned int ntimes, std::vector<T>& a, std::vector<T>& b, std::vector<T>& c, T& sum);
+bool check_solution(Stream<T> *stream, const unsigned int ntimes, T& sum, ArrayCheck& check);
 
 template <typename T>
 void run();
@@ -72,77 +235,600 @@ void run();
 // - All 5 kernels (Copy, Add, Mul, Triad, Dot).
 // - Triad only.
 // - Nstream only.
-enum class Benchmark {All, Triad, Nstream};
+// - Pointer-chasing latency only.
+// - Pointer-chasing latency while Triad or Copy load the memory system.
+// - Gather and Scatter only.
+enum class Benchmark {All, Triad, Nstream, Latency, LoadedLatency, GatherScatter};
 
 // Selected run options.
 Benchmark selection = Benchmark::All;
 
 void parseArguments(int argc, char *argv[]);
 
+// The implementation being run and its device functions
+const char *implementation_name()
+{
+#if defined(PLUGIN_DRIVER)
+  return current_plugin ? current_plugin->implementation : "none";
+#else
+  return IMPLEMENTATION_STRING;
+#endif
+}
+
+std::string device_name(unsigned int index)
+{
+#if defined(PLUGIN_DRIVER)
+  return current_plugin->device_name(index);
+#else
+  return getDeviceName(index);
+#endif
+}
+
+std::string device_driver(unsigned int index)
+{
+#if defined(PLUGIN_DRIVER)
+  return current_plugin->device_driver(index);
+#else
+  return getDeviceDriver(index);
+#endif
+}
+
+void choose_array_size(size_t element_size);
+
+#if defined(PLUGIN_DRIVER)
+void run_plugins();
+#endif
+
 int main(int argc, char *argv[])
 {
 
   parseArguments(argc, argv);
 
+#if defined(PLUGIN_DRIVER)
+  if (plugins.empty())
+  {
+    std::cerr << "No implementation to run, load one or more with --plugin FILE" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (list_plugin_devices)
+  {
+    for (const StreamPlugin *plugin : plugins)
+    {
+      std::cout << plugin->implementation << ":" << std::endl;
+      plugin->list_devices();
+    }
+    exit(EXIT_SUCCESS);
+  }
+
+  if (!json_file.empty() && plugins.size() > 1)
+  {
+    std::cerr << "--json records a single implementation and cannot be used with more than one --plugin" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+#endif
+
+  if (until_stable && selection == Benchmark::Triad)
+  {
+    std::cerr << "--until-stable needs per-iteration timings and cannot be used with --triad-only" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (nontemporal && selection == Benchmark::Triad)
+  {
+    std::cerr << "--nontemporal cannot be used with --triad-only" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (use_access_order && selection != Benchmark::All)
+  {
+    std::cerr << "--order adds to the Copy and Triad of the default benchmark and cannot be used with other modes" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (cache_resident_repeats && (selection != Benchmark::All || nontemporal || use_access_order))
+  {
+    std::cerr << "--cache-resident only applies to the default benchmark and cannot be used with --nontemporal or --order" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (per_thread && (selection != Benchmark::All || cache_resident_repeats ||
+                     (use_schedule && loop_schedule.kind == LoopSchedule::Taskloop)))
+  {
+    std::cerr << "--per-thread only applies to the default benchmark and cannot be used with --cache-resident or taskloops" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (persistent && (selection != Benchmark::All || cache_resident_repeats || use_perf))
+  {
+    std::cerr << "--persistent only applies to the default benchmark and cannot be used with --cache-resident or --perf" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // The non-temporal, ordered, persistent and cache-resident kernels divide the loop as
+  // schedule(static) does so that every thread keeps touching its own part of the arrays
+  if (use_schedule && (nontemporal || use_access_order || persistent || cache_resident_repeats))
+  {
+    std::cerr << "--omp-schedule only applies to the default kernels and cannot be used with --nontemporal, --order, --persistent or --cache-resident" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (use_energy && selection != Benchmark::All)
+  {
+    std::cerr << "--energy only applies to the default benchmark" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (processes)
+  {
+#if !defined(__linux__)
+    std::cerr << "--processes needs a process-shared barrier and is only supported on Linux" << std::endl;
+    exit(EXIT_FAILURE);
+#endif
+    // Every worker must run the same number of iterations of the same kernels, or the others
+    // would be left waiting at the barrier
+    if (selection != Benchmark::All || until_stable || !json_file.empty() || !sweep_sizes.empty() ||
+        nontemporal || use_access_order || persistent || per_thread || scaling_max || use_perf || use_energy)
+    {
+      std::cerr << "--processes only applies to the default benchmark and cannot be used with --until-stable, "
+                << "--json, --sweep, --nontemporal, --order, --persistent, --per-thread, --scaling, --perf or --energy" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (auto_size != AutoSize::None && !sweep_sizes.empty())
+  {
+    std::cerr << "--arraysize auto and mem:PCT cannot be used with --sweep" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (nontemporal && selection == Benchmark::Latency)
+  {
+    std::cerr << "--nontemporal cannot be used with --latency" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (nontemporal && selection == Benchmark::GatherScatter)
+  {
+    std::cerr << "--nontemporal cannot be used with --gather-scatter" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (scaling_max)
+  {
+#if !defined(OMP) && !defined(SIMD) && !defined(TBB)
+    std::cerr << "--scaling needs to set the thread count of the implementation, which it can "
+              << "for the OpenMP, SIMD and TBB implementations" << std::endl;
+    exit(EXIT_FAILURE);
+#endif
+    if (!sweep_sizes.empty() || affinity_config().threads ||
+        selection == Benchmark::Latency || selection == Benchmark::LoadedLatency)
+    {
+      std::cerr << "--scaling cannot be used with --sweep, --threads, --latency or --loaded-latency" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    // Threads are pinned compactly unless --bind says otherwise, and the implementation is
+    // constructed with the most threads
+    if (affinity_config().bind.empty())
+      affinity_config().bind = "compact";
+    affinity_config().threads = scaling_max;
+  }
+
+  if (selection == Benchmark::LoadedLatency && (nontemporal || until_stable || !sweep_sizes.empty()))
+  {
+    std::cerr << "--loaded-latency cannot be used with --nontemporal, --until-stable or --sweep" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (auto_size != AutoSize::None)
+    choose_array_size(use_float ? sizeof(float) : sizeof(double));
+
+  // Latency is measured from chains that fit in L1 up to the array size, unless sizes are given
+  if (selection == Benchmark::Latency && sweep_sizes.empty())
+  {
+    const int element_size = use_float ? sizeof(float) : sizeof(double);
+    for (intptr_t n = 4096 / element_size; n < ARRAY_SIZE; n *= 2)
+      sweep_sizes.push_back(n);
+    sweep_sizes.push_back(ARRAY_SIZE);
+  }
+
+  // Allocate for the largest size once and run the smaller sizes on sub-ranges of it
+  if (!sweep_sizes.empty())
+    ARRAY_SIZE = sweep_sizes.back();
+
+  // Byte counts are kept in size_t; the largest is that of --triad-only, over every iteration
+  const size_t element_size = use_float ? sizeof(float) : sizeof(double);
+  const size_t most_bytes_per_element = element_size * std::max<size_t>(4, 3 * static_cast<size_t>(num_times));
+  if (static_cast<size_t>(ARRAY_SIZE) > std::numeric_limits<size_t>::max() / most_bytes_per_element)
+  {
+    std::cerr << "Array size " << ARRAY_SIZE << " is too large: its byte counts overflow" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // The blocks of --order blocks:SIZE may not be larger than the arrays, and AccessOrder keeps
+  // their number of elements as an int
+  if (use_access_order && access_order_kind == AccessOrder::Blocks &&
+      (access_block_bytes / static_cast<intptr_t>(element_size) > ARRAY_SIZE ||
+       access_block_bytes / static_cast<intptr_t>(element_size) > std::numeric_limits<int>::max()))
+  {
+    std::cerr << "The --order block size of " << access_block_bytes << " bytes is larger than the arrays" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // The index array of the gather and scatter kernels holds int
+  if (selection == Benchmark::GatherScatter && ARRAY_SIZE > std::numeric_limits<int>::max())
+  {
+    std::cerr << "--gather-scatter supports at most " << std::numeric_limits<int>::max()
+              << " elements" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
   if (!output_as_csv)
   {
     std::cout
       << "BabelStream" << std::endl
-      << "Version: " << VERSION_STRING << std::endl
-      << "Implementation: " << IMPLEMENTATION_STRING << std::endl;
+      << "Version: " << VERSION_STRING << std::endl;
+#if !defined(PLUGIN_DRIVER)
+    std::cout << "Implementation: " << IMPLEMENTATION_STRING << std::endl;
+#endif
   }
 
+#if defined(PLUGIN_DRIVER)
+  run_plugins();
+#else
   if (use_float)
     run<float>();
   else
     run<double>(); 
+#endif
+
+}
+
+
+// Decides whether the timing loop should run another iteration, given the timings so far.
+// Runs num_times iterations, then with --until-stable continues until the runtimes are stable.
+bool keep_iterating(const std::vector<std::vector<double>>& timings, unsigned int iterations,
+                    std::chrono::high_resolution_clock::time_point start)
+{
+  if (iterations < num_times)
+    return true;
+  if (!until_stable)
+    return false;
+
+  double elapsed = std::chrono::duration_cast<std::chrono::duration<double> >(
+    std::chrono::high_resolution_clock::now() - start).count();
+  if (elapsed > stable_time_budget)
+    return false;
+
+  // Bootstrapping is comparatively expensive, so only check at geometrically spaced iterations
+  unsigned int interval = stable_check_interval;
+  while (interval * 16 <= iterations)
+    interval *= 2;
+  if (iterations % interval)
+    return true;
+
+  for (size_t i = 0; i < timings.size(); i++)
+  {
+    // Ignore the first result
+    TimingStats stats = compute_stats(timings[i].begin()+1, timings[i].end(), 0.95, stable_check_resamples);
+    if (stats.ci_high - stats.ci_low > stable_ci_width * stats.median)
+      return true;
+  }
+  return false;
+}
+
+// What each worker thread did in the calls of one kernel with --per-thread
+struct ThreadStats
+{
+  // Thread number, and mean seconds and elements per call, of each thread that took part
+  std::vector<int> threads;
+  std::vector<double> seconds;
+  std::vector<double> elements;
+  // Thread with the longest mean time, and that time over the mean and the shortest
+  int slowest;
+  double max_over_mean;
+  double max_over_min;
+};
+
+// Summarises the per-thread records of the calls of one kernel; ignores the first call
+ThreadStats compute_thread_stats(const std::vector<std::vector<ThreadTiming>>& calls)
+{
+  ThreadStats stats = ThreadStats();
+  const size_t first = calls.size() > 1 ? 1 : 0;
+  const size_t threads = calls.empty() ? 0 : calls[0].size();
+  for (size_t t = 0; t < threads; t++)
+  {
+    double seconds = 0.0, elements = 0.0;
+    for (size_t k = first; k < calls.size(); k++)
+    {
+      if (t >= calls[k].size() || calls[k][t].elements == 0)
+        continue;
+      seconds += timer_seconds(calls[k][t].end - calls[k][t].start);
+      elements += calls[k][t].elements;
+    }
+    if (elements == 0.0)
+      continue;
+    stats.threads.push_back(t);
+    stats.seconds.push_back(seconds / (calls.size() - first));
+    stats.elements.push_back(elements / (calls.size() - first));
+  }
+  if (stats.threads.empty())
+    return stats;
+
+  size_t slowest = std::max_element(stats.seconds.begin(), stats.seconds.end()) - stats.seconds.begin();
+  double mean = std::accumulate(stats.seconds.begin(), stats.seconds.end(), 0.0) / stats.seconds.size();
+  stats.slowest = stats.threads[slowest];
+  stats.max_over_mean = stats.seconds[slowest] / mean;
+  stats.max_over_min = stats.seconds[slowest] / *std::min_element(stats.seconds.begin(), stats.seconds.end());
+  return stats;
+}
+
+// Prints the bandwidth of each thread in each of the five main kernels, then the slowest thread
+// and how much longer it took than the mean and the fastest
+void print_thread_stats(const std::vector<ThreadStats>& thread_stats,
+                        const std::vector<std::string>& labels, const std::vector<size_t>& sizes)
+{
+  const double scale = (mibibytes) ? std::pow(2.0, -20.0) : 1.0E-6;
+  const bool sweeping = !sweep_sizes.empty();
 
+  if (output_as_csv)
+    std::cout
+      << "function" << csv_separator
+      << "n_elements" << csv_separator
+      << "thread" << csv_separator
+      << ((mibibytes) ? "mibytes_per_sec" : "mbytes_per_sec") << csv_separator
+      << "runtime" << csv_separator
+      << "bytes" << std::endl;
+  else
+  {
+    std::cout << "Per-thread results (mean per call):" << std::endl;
+    if (sweeping)
+      std::cout << std::left << std::setw(12) << "Elements";
+    std::cout
+      << std::left << std::setw(12) << "Function"
+      << std::left << std::setw(12) << "Thread"
+      << std::left << std::setw(12) << ((mibibytes) ? "MiBytes/sec" : "MBytes/sec")
+      << std::left << std::setw(12) << "Runtime"
+      << std::left << std::setw(12) << "Bytes" << std::endl;
+  }
+  for (size_t i = 0; i < thread_stats.size(); i++)
+  {
+    const ThreadStats& stats = thread_stats[i];
+    for (size_t t = 0; t < stats.threads.size(); t++)
+    {
+      const double bytes = stats.elements[t] * sizes[i] / ARRAY_SIZE;
+      if (output_as_csv)
+        std::cout
+          << labels[i] << csv_separator
+          << ARRAY_SIZE << csv_separator
+          << stats.threads[t] << csv_separator
+          << scale * bytes / stats.seconds[t] << csv_separator
+          << stats.seconds[t] << csv_separator
+          << bytes << std::endl;
+      else
+      {
+        if (sweeping)
+          std::cout << std::left << std::setw(12) << ARRAY_SIZE;
+        std::cout
+          << std::left << std::setw(12) << labels[i]
+          << std::left << std::setw(12) << stats.threads[t]
+          << std::left << std::setw(12) << std::setprecision(3) << scale * bytes / stats.seconds[t]
+          << std::left << std::setw(12) << std::setprecision(5) << stats.seconds[t]
+          << std::left << std::setw(12) << std::setprecision(0) << bytes << std::endl;
+      }
+    }
+  }
+
+  if (output_as_csv)
+    return;
+  std::cout << "Load imbalance (time of the slowest thread over the mean and the fastest):" << std::endl;
+  if (sweeping)
+    std::cout << std::left << std::setw(12) << "Elements";
+  std::cout
+    << std::left << std::setw(12) << "Function"
+    << std::left << std::setw(12) << "Slowest"
+    << std::left << std::setw(12) << "Max/mean"
+    << std::left << std::setw(12) << "Max/min" << std::endl;
+  for (size_t i = 0; i < thread_stats.size(); i++)
+  {
+    const ThreadStats& stats = thread_stats[i];
+    if (stats.threads.empty())
+      continue;
+    if (sweeping)
+      std::cout << std::left << std::setw(12) << ARRAY_SIZE;
+    std::cout
+      << std::left << std::setw(12) << labels[i]
+      << std::left << std::setw(12) << stats.slowest
+      << std::left << std::setw(12) << std::setprecision(3) << stats.max_over_mean
+      << std::left << std::setw(12) << std::setprecision(3) << stats.max_over_min << std::endl;
+  }
 }
 
+// Seconds for one pass of the kernel just timed from t1 to t2, which in cache-resident mode is
+// the implementation's own timing of the repetitions, spread over them
+template <typename T>
+double kernel_seconds(Stream<T> *stream, std::chrono::high_resolution_clock::time_point t1,
+                      std::chrono::high_resolution_clock::time_point t2)
+{
+  if (cache_resident_repeats)
+    return timer_seconds(stream->repeat_ticks()) / cache_resident_repeats;
+  return std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+}
 
 // Run the 5 main kernels
 template <typename T>
 std::vector<std::vector<double>> run_all(Stream<T> *stream, T& sum)
 {
 
-  // List of times
-  std::vector<std::vector<double>> timings(5);
+  // List of times, followed by those of the non-temporal Copy, Mul, Add and Triad,
+  // then those of Copy and Triad in the order given with --order
+  const size_t ordered = nontemporal ? 9 : 5;
+  std::vector<std::vector<double>> timings(ordered + (access_order ? 2 : 0));
+
+  if (per_thread)
+    thread_records.assign(5, std::vector<std::vector<ThreadTiming>>());
 
   // Declare timers
   std::chrono::high_resolution_clock::time_point t1, t2;
+  auto start = std::chrono::high_resolution_clock::now();
 
   // Main loop
-  for (unsigned int k = 0; k < num_times; k++)
+  for (unsigned int k = 0; keep_iterating(timings, k, start); k++)
   {
     // Execute Copy
+    if (process_group) process_group->start(0, k);
+    if (energy) energy->start();
+    if (perf) perf->start();
     t1 = std::chrono::high_resolution_clock::now();
     stream->copy();
     t2 = std::chrono::high_resolution_clock::now();
-    timings[0].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    if (process_group) process_group->stop(0, k);
+    timings[0].push_back(kernel_seconds(stream, t1, t2));
+    if (perf) perf->stop(0);
+    if (energy) energy->stop(0);
+    if (per_thread) thread_records[0].push_back(stream->thread_timings());
+
+    if (nontemporal)
+    {
+      stream->set_nontemporal(true);
+      if (process_group) process_group->wait();
+      if (energy) energy->start();
+      if (perf) perf->start();
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->copy();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[5].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+      if (perf) perf->stop(5);
+      if (energy) energy->stop(5);
+      stream->set_nontemporal(false);
+    }
+
+    if (access_order)
+    {
+      stream->set_access_order(access_order);
+      if (process_group) process_group->wait();
+      if (energy) energy->start();
+      if (perf) perf->start();
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->copy();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[ordered].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+      if (perf) perf->stop(ordered);
+      if (energy) energy->stop(ordered);
+      stream->set_access_order(nullptr);
+    }
 
     // Execute Mul
+    if (process_group) process_group->start(1, k);
+    if (energy) energy->start();
+    if (perf) perf->start();
     t1 = std::chrono::high_resolution_clock::now();
     stream->mul();
     t2 = std::chrono::high_resolution_clock::now();
-    timings[1].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    if (process_group) process_group->stop(1, k);
+    timings[1].push_back(kernel_seconds(stream, t1, t2));
+    if (perf) perf->stop(1);
+    if (energy) energy->stop(1);
+    if (per_thread) thread_records[1].push_back(stream->thread_timings());
+
+    if (nontemporal)
+    {
+      stream->set_nontemporal(true);
+      if (process_group) process_group->wait();
+      if (energy) energy->start();
+      if (perf) perf->start();
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->mul();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[6].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+      if (perf) perf->stop(6);
+      if (energy) energy->stop(6);
+      stream->set_nontemporal(false);
+    }
 
     // Execute Add
+    if (process_group) process_group->start(2, k);
+    if (energy) energy->start();
+    if (perf) perf->start();
     t1 = std::chrono::high_resolution_clock::now();
     stream->add();
     t2 = std::chrono::high_resolution_clock::now();
-    timings[2].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    if (process_group) process_group->stop(2, k);
+    timings[2].push_back(kernel_seconds(stream, t1, t2));
+    if (perf) perf->stop(2);
+    if (energy) energy->stop(2);
+    if (per_thread) thread_records[2].push_back(stream->thread_timings());
+
+    if (nontemporal)
+    {
+      stream->set_nontemporal(true);
+      if (process_group) process_group->wait();
+      if (energy) energy->start();
+      if (perf) perf->start();
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->add();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[7].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+      if (perf) perf->stop(7);
+      if (energy) energy->stop(7);
+      stream->set_nontemporal(false);
+    }
 
     // Execute Triad
+    if (process_group) process_group->start(3, k);
+    if (energy) energy->start();
+    if (perf) perf->start();
     t1 = std::chrono::high_resolution_clock::now();
     stream->triad();
     t2 = std::chrono::high_resolution_clock::now();
-    timings[3].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    if (process_group) process_group->stop(3, k);
+    timings[3].push_back(kernel_seconds(stream, t1, t2));
+    if (perf) perf->stop(3);
+    if (energy) energy->stop(3);
+    if (per_thread) thread_records[3].push_back(stream->thread_timings());
+
+    if (nontemporal)
+    {
+      stream->set_nontemporal(true);
+      if (process_group) process_group->wait();
+      if (energy) energy->start();
+      if (perf) perf->start();
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->triad();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[8].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+      if (perf) perf->stop(8);
+      if (energy) energy->stop(8);
+      stream->set_nontemporal(false);
+    }
+
+    if (access_order)
+    {
+      stream->set_access_order(access_order);
+      if (process_group) process_group->wait();
+      if (energy) energy->start();
+      if (perf) perf->start();
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->triad();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[ordered + 1].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+      if (perf) perf->stop(ordered + 1);
+      if (energy) energy->stop(ordered + 1);
+      stream->set_access_order(nullptr);
+    }
 
     // Execute Dot
+    if (process_group) process_group->start(4, k);
+    if (energy) energy->start();
+    if (perf) perf->start();
     t1 = std::chrono::high_resolution_clock::now();
     sum = stream->dot();
     t2 = std::chrono::high_resolution_clock::now();
-    timings[4].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    if (process_group) process_group->stop(4, k);
+    timings[4].push_back(kernel_seconds(stream, t1, t2));
+    if (perf) perf->stop(4);
+    if (energy) energy->stop(4);
+    if (per_thread) thread_records[4].push_back(stream->thread_timings());
 
   }
 
@@ -161,12 +847,14 @@ std::vector<std::vector<double>> run_triad(Stream<T> *stream)
   std::chrono::high_resolution_clock::time_point t1, t2;
 
   // Run triad in loop
+  if (perf) perf->start();
   t1 = std::chrono::high_resolution_clock::now();
   for (unsigned int k = 0; k < num_times; k++)
   {
     stream->triad();
   }
   t2 = std::chrono::high_resolution_clock::now();
+  if (perf) perf->stop(0);
 
   double runtime = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
   timings[0].push_back(runtime);
@@ -178,17 +866,33 @@ std::vector<std::vector<double>> run_triad(Stream<T> *stream)
 template <typename T>
 std::vector<std::vector<double>> run_nstream(Stream<T> *stream)
 {
-  std::vector<std::vector<double>> timings(1);
+  std::vector<std::vector<double>> timings(nontemporal ? 2 : 1);
 
   // Declare timers
   std::chrono::high_resolution_clock::time_point t1, t2;
 
+  auto start = std::chrono::high_resolution_clock::now();
+
   // Run nstream in loop
-  for (int k = 0; k < num_times; k++) {
+  for (unsigned int k = 0; keep_iterating(timings, k, start); k++) {
+    if (perf) perf->start();
     t1 = std::chrono::high_resolution_clock::now();
     stream->nstream();
     t2 = std::chrono::high_resolution_clock::now();
     timings[0].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    if (perf) perf->stop(0);
+
+    if (nontemporal)
+    {
+      stream->set_nontemporal(true);
+      if (perf) perf->start();
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->nstream();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[1].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+      if (perf) perf->stop(1);
+      stream->set_nontemporal(false);
+    }
   }
 
   return timings;
@@ -196,120 +900,359 @@ std::vector<std::vector<double>> run_nstream(Stream<T> *stream)
 }
 
 
-// Generic run routine
-// Runs the kernel(s) and prints output.
+// Run the Gather and Scatter kernels
 template <typename T>
-void run()
+std::vector<std::vector<double>> run_gather_scatter(Stream<T> *stream)
 {
-  std::streamsize ss = std::cout.precision();
-
-  if (!output_as_csv)
-  {
-    if (selection == Benchmark::All)
-      std::cout << "Running kernels " << num_times << " times" << std::endl;
-    else if (selection == Benchmark::Triad)
-    {
-      std::cout << "Running triad " << num_times << " times" << std::endl;
-      std::cout << "Number of elements: " << ARRAY_SIZE << std::endl;
-    }
-
 
-    if (sizeof(T) == sizeof(float))
-      std::cout << "Precision: float" << std::endl;
-    else
-      std::cout << "Precision: double" << std::endl;
+  // List of times
+  std::vector<std::vector<double>> timings(2);
 
+  // Declare timers
+  std::chrono::high_resolution_clock::time_point t1, t2;
+  auto start = std::chrono::high_resolution_clock::now();
 
-    if (mibibytes)
-    {
-      // MiB = 2^20
-      std::cout << std::setprecision(1) << std::fixed
-                << "Array size: " << ARRAY_SIZE*sizeof(T)*std::pow(2.0, -20.0) << " MiB"
-                << " (=" << ARRAY_SIZE*sizeof(T)*std::pow(2.0, -30.0) << " GiB)" << std::endl;
-      std::cout << "Total size: " << 3.0*ARRAY_SIZE*sizeof(T)*std::pow(2.0, -20.0) << " MiB"
-                << " (=" << 3.0*ARRAY_SIZE*sizeof(T)*std::pow(2.0, -30.0) << " GiB)" << std::endl;
-    }
-    else
-    {
-      // MB = 10^6
-      std::cout << std::setprecision(1) << std::fixed
-                << "Array size: " << ARRAY_SIZE*sizeof(T)*1.0E-6 << " MB"
-                << " (=" << ARRAY_SIZE*sizeof(T)*1.0E-9 << " GB)" << std::endl;
-      std::cout << "Total size: " << 3.0*ARRAY_SIZE*sizeof(T)*1.0E-6 << " MB"
-                << " (=" << 3.0*ARRAY_SIZE*sizeof(T)*1.0E-9 << " GB)" << std::endl;
-    }
-    std::cout.precision(ss);
+  for (unsigned int k = 0; keep_iterating(timings, k, start); k++)
+  {
+    // Execute Gather
+    if (perf) perf->start();
+    t1 = std::chrono::high_resolution_clock::now();
+    stream->gather();
+    t2 = std::chrono::high_resolution_clock::now();
+    timings[0].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    if (perf) perf->stop(0);
 
+    // Execute Scatter
+    if (perf) perf->start();
+    t1 = std::chrono::high_resolution_clock::now();
+    stream->scatter();
+    t2 = std::chrono::high_resolution_clock::now();
+    timings[1].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    if (perf) perf->stop(1);
   }
 
-  Stream<T> *stream;
+  return timings;
 
-#if defined(CUDA)
-  // Use the CUDA implementation
-  stream = new CUDAStream<T>(ARRAY_SIZE, deviceIndex);
+}
 
-#elif defined(HIP)
-  // Use the HIP implementation
-  stream = new HIPStream<T>(ARRAY_SIZE, deviceIndex);
 
-#elif defined(HC)
-  // Use the HC implementation
-  stream = new HCStream<T>(ARRAY_SIZE, deviceIndex);
+// The --omp-schedule option as given
+std::string loop_schedule_name()
+{
+  const char *kinds[] = {"static", "dynamic", "guided", "taskloop"};
+  std::string name = kinds[loop_schedule.kind];
+  if (loop_schedule.chunk > 0)
+    name += "," + std::to_string(loop_schedule.chunk);
+  return name;
+}
 
-#elif defined(OCL)
-  // Use the OpenCL implementation
-  stream = new OCLStream<T>(ARRAY_SIZE, deviceIndex);
+// The --order option as given, and as a short suffix for the kernel labels
+std::string access_order_name()
+{
+  if (access_order_kind == AccessOrder::Reverse)
+    return "reverse";
+  if (access_order_kind == AccessOrder::Strided)
+    return "stride:" + std::to_string(access_stride);
+  if (access_block_bytes % (1024 * 1024) == 0)
+    return "blocks:" + std::to_string(access_block_bytes / (1024 * 1024)) + "m";
+  if (access_block_bytes % 1024 == 0)
+    return "blocks:" + std::to_string(access_block_bytes / 1024) + "k";
+  return "blocks:" + std::to_string(access_block_bytes);
+}
 
-#elif defined(USE_RAJA)
-  // Use the RAJA implementation
-  stream = new RAJAStream<T>(ARRAY_SIZE, deviceIndex);
+std::string access_order_label()
+{
+  if (access_order_kind == AccessOrder::Reverse)
+    return "Rev";
+  if (access_order_kind == AccessOrder::Strided)
+    return "S" + std::to_string(access_stride);
+  std::string name = access_order_name();
+  std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+  return "B" + name.substr(7);
+}
 
-#elif defined(KOKKOS)
-  // Use the Kokkos implementation
-  stream = new KokkosStream<T>(ARRAY_SIZE, deviceIndex);
 
-#elif defined(STD_DATA)
-  // Use the C++ STD data-oriented implementation
-  stream = new STDDataStream<T>(ARRAY_SIZE, deviceIndex);
+// Construct the selected implementation with the given number of elements
+template <typename T>
+Stream<T> *make_stream(const intptr_t array_size)
+{
+#if defined(PLUGIN_DRIVER)
+  return plugin_stream<T>(*current_plugin, array_size, deviceIndex);
+#else
+  return make_model_stream<T>(array_size, deviceIndex);
+#endif
+}
 
-#elif defined(STD_INDICES)
-  // Use the C++ STD index-oriented implementation
-  stream = new STDIndicesStream<T>(ARRAY_SIZE, deviceIndex);
+// Sets up the optional features selected on the command line, failing if the implementation
+// does not support one
+template <typename T>
+void configure_stream(Stream<T> *stream)
+{
+  if (nontemporal && !stream->set_nontemporal(false))
+  {
+    std::cerr << "Non-temporal kernels are not supported by the "
+              << implementation_name() << " implementation" << std::endl;
+    exit(EXIT_FAILURE);
+  }
 
-#elif defined(STD_RANGES)
-  // Use the C++ STD ranges implementation
-  stream = new STDRangesStream<T>(ARRAY_SIZE, deviceIndex);
+  if (per_thread && !stream->set_instrumented(true))
+  {
+    std::cerr << "Per-thread instrumentation is not supported by the "
+              << implementation_name() << " implementation" << std::endl;
+    exit(EXIT_FAILURE);
+  }
 
-#elif defined(TBB)
-  // Use the C++20 implementation
-  stream = new TBBStream<T>(ARRAY_SIZE, deviceIndex);
+  if (use_schedule && !stream->set_schedule(loop_schedule))
+  {
+    std::cerr << "Loop schedules are not supported by the "
+              << implementation_name() << " implementation" << std::endl;
+    exit(EXIT_FAILURE);
+  }
 
-#elif defined(THRUST)
-  // Use the Thrust implementation
-  stream = new ThrustStream<T>(ARRAY_SIZE, deviceIndex); 
+  if (persistent)
+  {
+    std::vector<std::vector<double>> probe(5);
+    T sum{};
+    if (!stream->run_persistent(0, probe, sum))
+    {
+      std::cerr << "Persistent parallel regions are not supported by the "
+                << implementation_name() << " implementation" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (cache_resident_repeats && !stream->set_repeats(cache_resident_repeats))
+  {
+    std::cerr << "Cache-resident mode is not supported by the "
+              << implementation_name() << " implementation" << std::endl;
+    exit(EXIT_FAILURE);
+  }
 
-#elif defined(ACC)
-  // Use the OpenACC implementation
-  stream = new ACCStream<T>(ARRAY_SIZE, deviceIndex);
+  if (use_access_order && !stream->set_access_order(nullptr))
+  {
+    std::cerr << "Access orders other than sequential are not supported by the "
+              << implementation_name() << " implementation" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
 
-#elif defined(SYCL) || defined(SYCL2020)
-  // Use the SYCL implementation
-  stream = new SYCLStream<T>(ARRAY_SIZE, deviceIndex);
 
-#elif defined(OMP)
-  // Use the OpenMP implementation
-  stream = new OMPStream<T>(ARRAY_SIZE, deviceIndex);
+// Bandwidth per watt of a kernel, in GB/s/W (GiB/s/W with --mibibytes): the bytes it moves
+// per call over the mean energy of a call in every RAPL domain
+double energy_efficiency(const EnergyCounters& counters, size_t kernel, double bytes)
+{
+  const double joules = counters.joules(kernel);
+  return joules > 0.0 ? ((mibibytes) ? std::pow(2.0, -30.0) : 1.0E-9) * bytes / joules : 0.0;
+}
 
-#elif defined(FUTHARK)
-  // Use the Futhark implementation
-  stream = new FutharkStream<T>(ARRAY_SIZE, deviceIndex);
+// Prints the mean hardware counts per kernel call after the timing results, along with the
+// DRAM traffic measured by the memory controllers as a multiple of the bytes STREAM counts.
+// This is a separate table, so it is printed in full for each array size of a sweep.
+void print_counters(const PerfCounters& counters, const std::vector<std::string>& labels,
+                    const std::vector<size_t>& sizes)
+{
+  const bool sweeping = !sweep_sizes.empty();
+  std::vector<std::string> names = counters.names();
+  const int cycles = counters.find("cycles");
+  const int instructions = counters.find("instructions");
+  const int imc_read = counters.find("imc_read_bytes");
+  const int imc_write = counters.find("imc_write_bytes");
+  const bool ipc = cycles >= 0 && instructions >= 0;
+  const bool dram = imc_read >= 0 || imc_write >= 0;
 
-#endif
+  if (output_as_csv)
+  {
+    std::cout << "function" << csv_separator << "n_elements";
+    for (const std::string& name : names)
+      std::cout << csv_separator << name;
+    if (ipc)
+      std::cout << csv_separator << "ipc";
+    if (dram)
+      std::cout << csv_separator << "dram_bytes_ratio";
+    std::cout << std::endl;
+  }
+  else
+  {
+    std::cout << std::endl;
+    if (sweeping)
+      std::cout << std::left << std::setw(12) << "Elements";
+    std::cout << std::left << std::setw(12) << "Function";
+    for (const std::string& name : names)
+      std::cout << std::left << std::setw(16) << name;
+    if (ipc)
+      std::cout << std::left << std::setw(8) << "IPC";
+    if (dram)
+      std::cout << std::left << std::setw(12) << "DRAM/STREAM";
+    std::cout << std::endl;
+  }
+
+  for (size_t i = 0; i < labels.size(); i++)
+  {
+    std::vector<double> values = counters.average(i);
+    double imc_bytes = (imc_read >= 0 ? values[imc_read] : 0.0) + (imc_write >= 0 ? values[imc_write] : 0.0);
+
+    if (output_as_csv)
+    {
+      std::cout << labels[i] << csv_separator << ARRAY_SIZE;
+      for (double v : values)
+        std::cout << csv_separator << v;
+      if (ipc)
+        std::cout << csv_separator << values[instructions] / values[cycles];
+      if (dram)
+        std::cout << csv_separator << imc_bytes / sizes[i];
+      std::cout << std::endl;
+    }
+    else
+    {
+      if (sweeping)
+        std::cout << std::left << std::setw(12) << ARRAY_SIZE;
+      std::cout << std::left << std::setw(12) << labels[i] << std::setprecision(0);
+      for (double v : values)
+        std::cout << std::left << std::setw(16) << v;
+      if (ipc)
+        std::cout << std::left << std::setw(8) << std::setprecision(2) << values[instructions] / values[cycles];
+      if (dram)
+        std::cout << std::left << std::setw(12) << std::setprecision(2) << imc_bytes / sizes[i];
+      std::cout << std::endl;
+    }
+  }
+}
+
+// Samples the NUMA node of the pages of every host array, printing the result for the first run
+// of each implementation. Returns the fraction of each array's pages on each node.
+std::vector<std::vector<double>> report_numa_placement()
+{
+  std::vector<std::vector<double>> placement;
+  for (const HostAllocation& allocation : host_allocations())
+    placement.push_back(numa_placement(allocation));
+
+  if (!placement_reported)
+  {
+    placement_reported = true;
+    if (placement.empty())
+      std::cerr << "Warning: NUMA placement is not supported by the "
+                << implementation_name() << " implementation" << std::endl;
+    else if (!output_as_csv)
+    {
+      std::cout << "NUMA placement (sampled pages):" << std::endl;
+      for (size_t i = 0; i < placement.size(); i++)
+      {
+        std::cout << "  array " << i << ":";
+        for (size_t node = 0; node < placement[i].size(); node++)
+        {
+          std::ostringstream percent;
+          percent << std::fixed << std::setprecision(1) << 100.0 * placement[i][node];
+          std::cout << " node " << node << " " << percent.str() << "%";
+        }
+        if (placement[i].empty())
+          std::cout << " unknown";
+        std::cout << std::endl;
+      }
+    }
+  }
+  return placement;
+}
+
+// Runs the selected kernel(s) on the first ARRAY_SIZE elements of stream,
+// then checks the solution and prints the results.
+// The table header is only printed if print_header is set so that a sweep produces a single table.
+template <typename T>
+void run_benchmark(Stream<T> *stream, bool print_header)
+{
+  const bool sweeping = !sweep_sizes.empty();
 
   auto init1 = std::chrono::high_resolution_clock::now();
   stream->init_arrays(startA, startB, startC);
   auto init2 = std::chrono::high_resolution_clock::now();
 
+  // Where the pages of each array actually are, and what size they are, now they have been touched
+  std::vector<std::vector<double>> placement;
+  if (numa_config().policy != NumaPolicy::Default)
+    placement = report_numa_placement();
+  PageUsage page_usage;
+  bool have_page_usage = host_page_usage(page_usage);
+  if (have_page_usage && !output_as_csv && !sweeping
+      && (page_config().backend != PageBackend::Default || page_config().prefault))
+  {
+    std::ostringstream usage;
+    usage << std::fixed << std::setprecision(1)
+          << "Pages: " << page_usage.resident / 1024.0 << " MiB resident, "
+          << page_usage.thp / 1024.0 << " MiB transparent huge pages, "
+          << page_usage.hugetlb / 1024.0 << " MiB hugetlb pages";
+    std::cout << usage.str() << std::endl;
+  }
+
+  // Counters are opened once the implementation has started its threads
+  std::unique_ptr<PerfCounters> counters;
+  if (use_perf)
+  {
+    size_t kernels = (selection == Benchmark::All) ? 5 : (selection == Benchmark::GatherScatter) ? 2 : 1;
+    if (nontemporal)
+      kernels = (selection == Benchmark::All) ? 9 : 2;
+    if (use_access_order)
+      kernels += 2;
+    counters.reset(new PerfCounters(kernels));
+    static bool warned = false;
+    if (counters->available())
+      perf = counters.get();
+    else if (!warned)
+    {
+      std::cerr << "Warning: no performance counters could be opened ("
+        << counters->error() << "); check /proc/sys/kernel/perf_event_paranoid" << std::endl;
+      warned = true;
+    }
+  }
+
+  // Without RAPL counters the energy columns are left out
+  std::unique_ptr<EnergyCounters> energy_counters;
+  if (use_energy)
+  {
+    size_t kernels = nontemporal ? 9 : 5;
+    if (use_access_order)
+      kernels += 2;
+    energy_counters.reset(new EnergyCounters(kernels));
+    static bool warned = false;
+    if (energy_counters->available())
+      energy = energy_counters.get();
+    else if (!warned)
+    {
+      std::cerr << "Warning: no RAPL energy counters could be read ("
+        << energy_counters->error() << "); energy_uj is often readable by root only" << std::endl;
+      warned = true;
+    }
+  }
+  const bool energy_columns = energy != nullptr;
+
+  // Cache lines the gather and scatter kernels move through their index array
+  size_t index_lines = 0;
+  if (selection == Benchmark::GatherScatter)
+  {
+    std::vector<int> indices = make_indices(index_config, ARRAY_SIZE);
+    if (!stream->set_indices(indices))
+    {
+      std::cerr << "Gather and scatter are not supported by the "
+                << implementation_name() << " implementation" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    index_lines = indirect_lines(indices, sizeof(T));
+  }
+
+  // Copy and Triad are run again in the --order order; the blocks are shuffled for each array size
+  AccessOrder order;
+  if (use_access_order)
+  {
+    order.kind = access_order_kind;
+    order.stride = access_stride;
+    order.block_size = std::max<intptr_t>(1, access_block_bytes / sizeof(T));
+    if (order.kind == AccessOrder::Blocks)
+    {
+      for (intptr_t start = 0; start < ARRAY_SIZE; start += order.block_size)
+        order.blocks.push_back(start);
+      std::shuffle(order.blocks.begin(), order.blocks.end(), std::mt19937_64(42));
+    }
+    access_order = &order;
+  }
+
   // Result of the Dot kernel, if used.
   T sum{};
 
@@ -326,25 +1269,49 @@ void run()
     case Benchmark::Nstream:
       timings = run_nstream<T>(stream);
       break;
+    case Benchmark::GatherScatter:
+      timings = run_gather_scatter<T>(stream);
+      break;
+    default:
+      break;
   };
 
-  // Check solutions
-  // Create host vectors
-  std::vector<T> a(ARRAY_SIZE);
-  std::vector<T> b(ARRAY_SIZE);
-  std::vector<T> c(ARRAY_SIZE);
+  perf = nullptr;
+  energy = nullptr;
+  access_order = nullptr;
 
+  // The same number of iterations again in one parallel region, appended to the timings
+  const size_t persistent_base = timings.size();
+  if (persistent)
+  {
+    timings.resize(persistent_base + 5);
+    std::vector<std::vector<double>> persistent_timings(5);
+    stream->run_persistent(timings[0].size(), persistent_timings, sum);
+    std::move(persistent_timings.begin(), persistent_timings.end(), timings.begin() + persistent_base);
+  }
 
-  auto read1 = std::chrono::high_resolution_clock::now();
-  stream->read_arrays(a, b, c);
-  auto read2 = std::chrono::high_resolution_clock::now();
+  // The number of iterations can differ from num_times with --until-stable
+  const unsigned int iterations = (selection == Benchmark::Triad) ? num_times : timings[0].size();
 
-  auto initElapsedS = std::chrono::duration_cast<std::chrono::duration<double>>(read2 - read1).count();
-  auto readElapsedS = std::chrono::duration_cast<std::chrono::duration<double>>(init2 - init1).count();
+  // Check solutions
+  // Running the non-temporal variant straight after each kernel repeats it with the same
+  // result, except for Nstream which accumulates into a. The persistent region runs the
+  // whole sequence of kernels again.
+  ArrayCheck check = {};
+  bool valid = true;
+  if (verify_mode != VerifyMode::None)
+    valid = check_solution<T>(stream, (selection == Benchmark::Nstream && nontemporal) || persistent ? 2 * iterations : iterations,
+                              sum, check);
+  const bool verified = verify_mode != VerifyMode::None;
+  const char *check_phase = check.read_back ? "Read" : "Verify";
+
+  auto initElapsedS = std::chrono::duration_cast<std::chrono::duration<double>>(init2 - init1).count();
+  auto readElapsedS = check.seconds;
   auto initBWps = ((mibibytes ? std::pow(2.0, -20.0) : 1.0E-6) * (3 * sizeof(T) * ARRAY_SIZE)) / initElapsedS;
-  auto readBWps = ((mibibytes ? std::pow(2.0, -20.0) : 1.0E-6) * (3 * sizeof(T) * ARRAY_SIZE)) / readElapsedS;
+  auto readBWps = ((mibibytes ? std::pow(2.0, -20.0) : 1.0E-6) * check.bytes) / readElapsedS;
 
-  if (output_as_csv)
+  // Init and read timings are only reported for a single array size
+  if (output_as_csv && !sweeping)
   {
     std::cout
       << "phase" << csv_separator
@@ -358,14 +1325,15 @@ void run()
       << sizeof(T) << csv_separator
       << initBWps << csv_separator
       << initElapsedS << std::endl;
-    std::cout
-      << "Read" << csv_separator
-      << ARRAY_SIZE << csv_separator
-      << sizeof(T) << csv_separator
-      << readBWps << csv_separator
-      << readElapsedS << std::endl;
+    if (verified)
+      std::cout
+        << check_phase << csv_separator
+        << ARRAY_SIZE << csv_separator
+        << sizeof(T) << csv_separator
+        << readBWps << csv_separator
+        << readElapsedS << std::endl;
   }
-  else
+  else if (!sweeping)
   {
     std::cout << "Init: "
       << std::setw(7)
@@ -374,19 +1342,231 @@ void run()
       << initBWps
       << (mibibytes ? " MiBytes/sec" : " MBytes/sec")
       << ")" << std::endl;
-    std::cout << "Read: "
-      << std::setw(7)
-      << readElapsedS
-      << " s (="
-      << readBWps
-      << (mibibytes ? " MiBytes/sec" : " MBytes/sec")
-      << ")" << std::endl;
+    if (verified)
+      std::cout << check_phase << ": "
+        << std::setw(7)
+        << readElapsedS
+        << " s (="
+        << readBWps
+        << (mibibytes ? " MiBytes/sec" : " MBytes/sec")
+        << ")" << std::endl;
+  }
+
+  if (until_stable && !output_as_csv && !sweeping)
+    std::cout << "Iterations: " << iterations << std::endl;
+
+  std::vector<std::string> labels;
+  std::vector<size_t> sizes;
+  // For Gather and Scatter, also the bytes moved counting whole cache lines on the indirect side
+  std::vector<size_t> line_sizes;
+
+  if (selection == Benchmark::All)
+  {
+    labels = {"Copy", "Mul", "Add", "Triad", "Dot"};
+    sizes = {
+      2 * sizeof(T) * ARRAY_SIZE,
+      2 * sizeof(T) * ARRAY_SIZE,
+      3 * sizeof(T) * ARRAY_SIZE,
+      3 * sizeof(T) * ARRAY_SIZE,
+      2 * sizeof(T) * ARRAY_SIZE};
+    if (nontemporal)
+    {
+      labels.insert(labels.end(), {"Copy NT", "Mul NT", "Add NT", "Triad NT"});
+      std::vector<size_t> nt_sizes(sizes.begin(), sizes.begin() + 4);
+      sizes.insert(sizes.end(), nt_sizes.begin(), nt_sizes.end());
+    }
+    if (use_access_order)
+    {
+      labels.push_back("Copy " + access_order_label());
+      labels.push_back("Triad " + access_order_label());
+      sizes.push_back(sizes[0]);
+      sizes.push_back(sizes[3]);
+    }
+    if (persistent)
+    {
+      labels.insert(labels.end(), {"Copy PR", "Mul PR", "Add PR", "Triad PR", "Dot PR"});
+      std::vector<size_t> pr_sizes(sizes.begin(), sizes.begin() + 5);
+      sizes.insert(sizes.end(), pr_sizes.begin(), pr_sizes.end());
+    }
+  } else if (selection == Benchmark::Triad)
+  {
+    // A single timing for all iterations
+    labels = {"Triad"};
+    sizes = {3 * sizeof(T) * ARRAY_SIZE * num_times};
+  } else if (selection == Benchmark::Nstream)
+  {
+    labels = {"Nstream"};
+    sizes = {4 * sizeof(T) * ARRAY_SIZE };
+    if (nontemporal)
+    {
+      labels.push_back("Nstream NT");
+      sizes.push_back(sizes[0]);
+    }
+  } else if (selection == Benchmark::GatherScatter)
+  {
+    // The index array, the unit-stride array and the elements of the indirect array
+    labels = {"Gather", "Scatter"};
+    sizes = {
+      (sizeof(int) + 2 * sizeof(T)) * ARRAY_SIZE,
+      (sizeof(int) + 2 * sizeof(T)) * ARRAY_SIZE};
+    line_sizes = {
+      (sizeof(int) + sizeof(T)) * ARRAY_SIZE + 64 * index_lines,
+      (sizeof(int) + sizeof(T)) * ARRAY_SIZE + 64 * index_lines};
+  }
+
+  for (size_t i = 0; i < timings.size(); i++)
+  {
+    // As in the tables below, the first iteration is ignored when there is more than one
+    double best = *std::min_element(timings[i].begin() + (timings[i].size() > 1 ? 1 : 0), timings[i].end());
+    best_bandwidths.push_back(std::make_pair(sweeping ? labels[i] + " " + std::to_string(ARRAY_SIZE) : labels[i],
+                                             sizes[i] / best));
   }
 
-  check_solution<T>(num_times, a, b, c, sum);
+  // Per-thread results of the five main kernels
+  std::vector<ThreadStats> thread_stats;
+  if (per_thread)
+    for (size_t i = 0; i < thread_records.size(); i++)
+      thread_stats.push_back(compute_thread_stats(thread_records[i]));
+
+  if (json)
+  {
+    json->begin_object();
+    json->field("array_size", ARRAY_SIZE);
+    if (scaling_max)
+      json->field("threads", affinity_config().threads);
+    json->field("iterations", iterations);
+    if (verified)
+      json->field("valid", valid);
+    if (!placement.empty())
+    {
+      json->key("numa_placement");
+      json->begin_array();
+      for (const std::vector<double>& fractions : placement)
+      {
+        json->begin_array();
+        for (double f : fractions)
+          json->value(f);
+        json->end_array();
+      }
+      json->end_array();
+    }
+    if (have_page_usage)
+    {
+      json->key("pages");
+      json->begin_object();
+      json->field("resident_kb", page_usage.resident);
+      json->field("thp_kb", page_usage.thp);
+      json->field("hugetlb_kb", page_usage.hugetlb);
+      json->field("page_size_kb", page_usage.page_size);
+      json->end_object();
+    }
+    json->key("init");
+    json->begin_object();
+    json->field("runtime", initElapsedS);
+    json->field("bytes", 3 * sizeof(T) * ARRAY_SIZE);
+    json->end_object();
+    if (verified)
+    {
+      json->key(check.read_back ? "read" : "verify");
+      json->begin_object();
+      json->field("runtime", readElapsedS);
+      json->field("bytes", check.bytes);
+      json->end_object();
+    }
+    json->key("kernels");
+    json->begin_array();
+    for (size_t i = 0; i < timings.size(); i++)
+    {
+      json->begin_object();
+      json->field("name", labels[i]);
+      json->field("bytes", sizes[i]);
+      // Every sample, including the first which is excluded from the statistics
+      json->array("timings", timings[i]);
+      if (timings[i].size() > 1)
+      {
+        TimingStats stats = compute_stats(timings[i].begin()+1, timings[i].end());
+        json->field("bandwidth_bytes_per_sec", sizes[i] / stats.min);
+        json->field("min", stats.min);
+        json->field("max", stats.max);
+        json->field("mean", stats.mean);
+        json->field("median", stats.median);
+        json->field("stddev", stats.stddev);
+        json->field("p5", stats.p5);
+        json->field("p95", stats.p95);
+        json->field("p99", stats.p99);
+        json->field("ci_low", stats.ci_low);
+        json->field("ci_high", stats.ci_high);
+      }
+      else
+      {
+        json->field("bandwidth_bytes_per_sec", sizes[i] / timings[i][0]);
+      }
+      if (i < thread_stats.size() && !thread_stats[i].threads.empty())
+      {
+        const ThreadStats& stats = thread_stats[i];
+        json->key("threads");
+        json->begin_array();
+        for (size_t t = 0; t < stats.threads.size(); t++)
+        {
+          const double bytes = stats.elements[t] * sizes[i] / ARRAY_SIZE;
+          json->begin_object();
+          json->field("thread", stats.threads[t]);
+          json->field("bytes", bytes);
+          json->field("runtime", stats.seconds[t]);
+          json->field("bandwidth_bytes_per_sec", bytes / stats.seconds[t]);
+          json->end_object();
+        }
+        json->end_array();
+        json->field("slowest_thread", stats.slowest);
+        json->field("imbalance_max_mean", stats.max_over_mean);
+        json->field("imbalance_max_min", stats.max_over_min);
+      }
+      if (persistent && i >= persistent_base && timings[i].size() > 1)
+      {
+        // Median runtime of the fork/join kernel less that of the same kernel in one region
+        json->field("fork_join_overhead",
+                    compute_stats(timings[i - persistent_base].begin()+1, timings[i - persistent_base].end()).median
+                    - compute_stats(timings[i].begin()+1, timings[i].end()).median);
+      }
+      if (!line_sizes.empty())
+      {
+        json->field("line_bytes", line_sizes[i]);
+        json->field("line_bandwidth_bytes_per_sec",
+                    line_sizes[i] / *std::min_element(timings[i].begin() + (timings[i].size() > 1 ? 1 : 0), timings[i].end()));
+      }
+      if (counters && counters->available())
+      {
+        // Mean counts per kernel call, or for the whole loop with --triad-only
+        std::vector<std::string> names = counters->names();
+        std::vector<double> values = counters->average(i);
+        json->key("counters");
+        json->begin_object();
+        for (size_t e = 0; e < names.size(); e++)
+          json->field(names[e], values[e]);
+        json->end_object();
+      }
+      if (energy_columns && i < energy_counters->kernels())
+      {
+        // Mean joules per kernel call in each RAPL domain
+        std::vector<std::string> names = energy_counters->names();
+        std::vector<double> values = energy_counters->average(i);
+        json->key("energy_joules");
+        json->begin_object();
+        for (size_t d = 0; d < names.size(); d++)
+          json->field(names[d], values[d]);
+        json->end_object();
+        json->field("power_watts", energy_counters->watts(i));
+        const double joules = energy_counters->joules(i);
+        json->field("bytes_per_joule", joules > 0.0 ? sizes[i] / joules : 0.0);
+      }
+      json->end_object();
+    }
+    json->end_array();
+    json->end_object();
+  }
 
   // Display timing results
-  if (output_as_csv)
+  if (print_header && output_as_csv)
   {
     std::cout
       << "function" << csv_separator
@@ -396,121 +1576,1579 @@ void run()
       << ((mibibytes) ? "max_mibytes_per_sec" : "max_mbytes_per_sec") << csv_separator
       << "min_runtime" << csv_separator
       << "max_runtime" << csv_separator
-      << "avg_runtime" << std::endl;
+      << "avg_runtime";
+    if (output_stats && selection != Benchmark::Triad)
+      std::cout
+        << csv_separator << "median_runtime"
+        << csv_separator << "stddev_runtime"
+        << csv_separator << "p5_runtime"
+        << csv_separator << "p95_runtime"
+        << csv_separator << "p99_runtime"
+        << csv_separator << "ci_low_runtime"
+        << csv_separator << "ci_high_runtime";
+    if (!line_sizes.empty())
+      std::cout << csv_separator << ((mibibytes) ? "max_line_mibytes_per_sec" : "max_line_mbytes_per_sec");
+    if (energy_columns)
+      std::cout
+        << csv_separator << "energy_joules"
+        << csv_separator << "power_watts"
+        << csv_separator << ((mibibytes) ? "gibytes_per_sec_per_watt" : "gbytes_per_sec_per_watt");
+    std::cout << std::endl;
   }
-  else
+  else if (print_header && !(sweeping && selection == Benchmark::Triad))
   {
+    if (sweeping)
+      std::cout << std::left << std::setw(12) << "Elements";
     std::cout
       << std::left << std::setw(12) << "Function"
       << std::left << std::setw(12) << ((mibibytes) ? "MiBytes/sec" : "MBytes/sec")
       << std::left << std::setw(12) << "Min (sec)"
       << std::left << std::setw(12) << "Max"
-      << std::left << std::setw(12) << "Average"
+      << std::left << std::setw(12) << "Average";
+    if (output_stats)
+      std::cout
+        << std::left << std::setw(12) << "Median"
+        << std::left << std::setw(12) << "Std dev"
+        << std::left << std::setw(12) << "P5"
+        << std::left << std::setw(12) << "P95"
+        << std::left << std::setw(12) << "P99"
+        << std::left << std::setw(24) << "95% CI (median)";
+    if (!line_sizes.empty())
+      std::cout << std::left << std::setw(12) << ((mibibytes) ? "Line MiB/s" : "Line MB/s");
+    if (energy_columns)
+      std::cout
+        << std::left << std::setw(12) << "Joules"
+        << std::left << std::setw(12) << "Watts"
+        << std::left << std::setw(12) << ((mibibytes) ? "GiB/s/W" : "GB/s/W");
+    std::cout
       << std::endl
       << std::fixed;
   }
 
 
-  if (selection == Benchmark::All || selection == Benchmark::Nstream)
+  if (selection == Benchmark::All || selection == Benchmark::Nstream || selection == Benchmark::GatherScatter)
+  {
+    for (size_t i = 0; i < timings.size(); ++i)
+    {
+      // Summarise the runtimes; ignore the first result
+      TimingStats stats = compute_stats(timings[i].begin()+1, timings[i].end());
+
+      // Display results
+      if (output_as_csv)
+      {
+        std::cout
+          << labels[i] << csv_separator
+          << iterations << csv_separator
+          << ARRAY_SIZE << csv_separator
+          << sizeof(T) << csv_separator
+          << ((mibibytes) ? std::pow(2.0, -20.0) : 1.0E-6) * sizes[i] / stats.min << csv_separator
+          << stats.min << csv_separator
+          << stats.max << csv_separator
+          << stats.mean;
+        if (output_stats)
+          std::cout
+            << csv_separator << stats.median
+            << csv_separator << stats.stddev
+            << csv_separator << stats.p5
+            << csv_separator << stats.p95
+            << csv_separator << stats.p99
+            << csv_separator << stats.ci_low
+            << csv_separator << stats.ci_high;
+        if (!line_sizes.empty())
+          std::cout << csv_separator << ((mibibytes) ? std::pow(2.0, -20.0) : 1.0E-6) * line_sizes[i] / stats.min;
+        // Rows with no energy measured, such as those of --persistent, leave the fields empty
+        if (energy_columns && i < energy_counters->kernels())
+          std::cout
+            << csv_separator << energy_counters->joules(i)
+            << csv_separator << energy_counters->watts(i)
+            << csv_separator << energy_efficiency(*energy_counters, i, sizes[i]);
+        else if (energy_columns)
+          std::cout << csv_separator << csv_separator << csv_separator;
+        std::cout << std::endl;
+      }
+      else
+      {
+        if (sweeping)
+          std::cout << std::left << std::setw(12) << ARRAY_SIZE;
+        std::cout
+          << std::left << std::setw(12) << labels[i]
+          << std::left << std::setw(12) << std::setprecision(3) << 
+            ((mibibytes) ? std::pow(2.0, -20.0) : 1.0E-6) * sizes[i] / stats.min
+          << std::left << std::setw(12) << std::setprecision(5) << stats.min
+          << std::left << std::setw(12) << std::setprecision(5) << stats.max
+          << std::left << std::setw(12) << std::setprecision(5) << stats.mean;
+        if (output_stats)
+        {
+          std::ostringstream ci;
+          ci << std::fixed << std::setprecision(5) << "[" << stats.ci_low << ", " << stats.ci_high << "]";
+          std::cout
+            << std::left << std::setw(12) << std::setprecision(5) << stats.median
+            << std::left << std::setw(12) << std::setprecision(5) << stats.stddev
+            << std::left << std::setw(12) << std::setprecision(5) << stats.p5
+            << std::left << std::setw(12) << std::setprecision(5) << stats.p95
+            << std::left << std::setw(12) << std::setprecision(5) << stats.p99
+            << std::left << std::setw(24) << ci.str();
+        }
+        if (!line_sizes.empty())
+          std::cout << std::left << std::setw(12) << std::setprecision(3)
+                    << ((mibibytes) ? std::pow(2.0, -20.0) : 1.0E-6) * line_sizes[i] / stats.min;
+        if (energy_columns && i < energy_counters->kernels())
+          std::cout
+            << std::left << std::setw(12) << std::setprecision(3) << energy_counters->joules(i)
+            << std::left << std::setw(12) << std::setprecision(1) << energy_counters->watts(i)
+            << std::left << std::setw(12) << std::setprecision(3) << energy_efficiency(*energy_counters, i, sizes[i]);
+        std::cout << std::endl;
+      }
+    }
+
+    if (!thread_stats.empty())
+      print_thread_stats(thread_stats, labels, sizes);
+
+    if (persistent && !output_as_csv)
+    {
+      std::cout << "Fork/join overhead (median runtime less that of the persistent region):" << std::endl;
+      for (size_t i = 0; i < 5; i++)
+      {
+        double fork_join = compute_stats(timings[i].begin()+1, timings[i].end()).median;
+        double region = compute_stats(timings[persistent_base + i].begin()+1, timings[persistent_base + i].end()).median;
+        if (sweeping)
+          std::cout << std::left << std::setw(12) << ARRAY_SIZE;
+        std::ostringstream overhead;
+        overhead << std::fixed << std::setprecision(3) << 1.0E6 * (fork_join - region) << " us";
+        std::cout
+          << std::left << std::setw(12) << labels[i]
+          << std::left << std::setw(16) << overhead.str()
+          << std::setprecision(1) << 100.0 * (fork_join - region) / fork_join << "%" << std::endl;
+      }
+    }
+  } else if (selection == Benchmark::Triad)
+  {
+    // Display timing results
+    double total_bytes = sizes[0];
+    double bandwidth = ((mibibytes) ? std::pow(2.0, -30.0) : 1.0E-9) * (total_bytes / timings[0][0]);
+
+    if (output_as_csv)
+    {
+      if (print_header)
+        std::cout
+          << "function" << csv_separator
+          << "num_times" << csv_separator
+          << "n_elements" << csv_separator
+          << "sizeof" << csv_separator
+          << ((mibibytes) ? "gibytes_per_sec" : "gbytes_per_sec") << csv_separator
+          << "runtime"
+          << std::endl;
+      std::cout
+        << "Triad" << csv_separator
+        << num_times << csv_separator
+        << ARRAY_SIZE << csv_separator
+        << sizeof(T) << csv_separator
+        << bandwidth << csv_separator
+        << timings[0][0]
+        << std::endl;
+    }
+    else if (sweeping)
+    {
+      if (print_header)
+        std::cout
+          << std::left << std::setw(12) << "Elements"
+          << std::left << std::setw(20) << "Runtime (sec)"
+          << std::left << std::setw(12) << ((mibibytes) ? "GiB/s" : "GB/s")
+          << std::endl << std::fixed;
+      std::cout
+        << std::left << std::setw(12) << ARRAY_SIZE
+        << std::left << std::setw(20) << std::setprecision(5) << timings[0][0]
+        << std::left << std::setw(12) << std::setprecision(3) << bandwidth
+        << std::endl;
+    }
+    else
+    {
+      std::cout
+        << "--------------------------------"
+        << std::endl << std::fixed
+        << "Runtime (seconds): " << std::left << std::setprecision(5)
+        << timings[0][0] << std::endl
+        << "Bandwidth (" << ((mibibytes) ? "GiB/s" : "GB/s") << "):  "
+        << std::left << std::setprecision(3)
+        << bandwidth << std::endl;
+    }
+  }
+
+  if (counters && counters->available())
+    print_counters(*counters, labels, sizes);
+
+}
+
+
+// Measures the load-to-use latency of a pointer chain the size of one array of ARRAY_SIZE elements,
+// printing a row of the latency table; the header is only printed if print_header is set
+template <typename T>
+void run_latency(bool print_header)
+{
+  PointerChain chain(ARRAY_SIZE * sizeof(T));
+  const size_t accesses = latency_accesses;
+
+  std::unique_ptr<PerfCounters> counters;
+  if (use_perf)
+  {
+    counters.reset(new PerfCounters(1));
+    if (counters->available())
+      perf = counters.get();
+  }
+
+  // Visit every line once so that none of the samples includes the page faults
+  chain.chase(chain.bytes() / PointerChain::line_size);
+
+  // Each sample carries on from where the last stopped
+  std::vector<std::vector<double>> timings(1);
+  auto start = std::chrono::high_resolution_clock::now();
+  for (unsigned int k = 0; keep_iterating(timings, k, start); k++)
+  {
+    if (perf) perf->start();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    chain.chase(accesses);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    timings[0].push_back(std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count());
+    if (perf) perf->stop(0);
+  }
+  perf = nullptr;
+
+  // Summarise in nanoseconds per access; ignore the first result
+  const unsigned int iterations = timings[0].size();
+  TimingStats stats = compute_stats(timings[0].begin()+1, timings[0].end());
+  const double ns = 1.0E9 / accesses;
+
+  if (json)
+  {
+    json->begin_object();
+    json->field("array_size", ARRAY_SIZE);
+    json->field("iterations", iterations);
+    json->key("kernels");
+    json->begin_array();
+    json->begin_object();
+    json->field("name", "Latency");
+    json->field("bytes", chain.bytes());
+    json->field("accesses", accesses);
+    json->array("timings", timings[0]);
+    json->field("latency_ns", ns * stats.min);
+    json->field("min", stats.min);
+    json->field("max", stats.max);
+    json->field("mean", stats.mean);
+    json->field("median", stats.median);
+    json->field("stddev", stats.stddev);
+    json->field("p5", stats.p5);
+    json->field("p95", stats.p95);
+    json->field("p99", stats.p99);
+    json->field("ci_low", stats.ci_low);
+    json->field("ci_high", stats.ci_high);
+    if (counters && counters->available())
+    {
+      std::vector<std::string> names = counters->names();
+      std::vector<double> values = counters->average(0);
+      json->key("counters");
+      json->begin_object();
+      for (size_t e = 0; e < names.size(); e++)
+        json->field(names[e], values[e]);
+      json->end_object();
+    }
+    json->end_object();
+    json->end_array();
+    json->end_object();
+  }
+
+  if (output_as_csv)
+  {
+    if (print_header)
+    {
+      std::cout
+        << "function" << csv_separator
+        << "num_times" << csv_separator
+        << "n_bytes" << csv_separator
+        << "accesses" << csv_separator
+        << "min_ns" << csv_separator
+        << "max_ns" << csv_separator
+        << "avg_ns";
+      if (output_stats)
+        std::cout
+          << csv_separator << "median_ns"
+          << csv_separator << "stddev_ns"
+          << csv_separator << "p5_ns"
+          << csv_separator << "p95_ns"
+          << csv_separator << "p99_ns"
+          << csv_separator << "ci_low_ns"
+          << csv_separator << "ci_high_ns";
+      std::cout << std::endl;
+    }
+    std::cout
+      << "Latency" << csv_separator
+      << iterations << csv_separator
+      << chain.bytes() << csv_separator
+      << accesses << csv_separator
+      << ns * stats.min << csv_separator
+      << ns * stats.max << csv_separator
+      << ns * stats.mean;
+    if (output_stats)
+      std::cout
+        << csv_separator << ns * stats.median
+        << csv_separator << ns * stats.stddev
+        << csv_separator << ns * stats.p5
+        << csv_separator << ns * stats.p95
+        << csv_separator << ns * stats.p99
+        << csv_separator << ns * stats.ci_low
+        << csv_separator << ns * stats.ci_high;
+    std::cout << std::endl;
+  }
+  else
   {
+    if (print_header)
+    {
+      std::cout
+        << std::left << std::setw(16) << "Bytes"
+        << std::left << std::setw(12) << "Min (ns)"
+        << std::left << std::setw(12) << "Max"
+        << std::left << std::setw(12) << "Average";
+      if (output_stats)
+        std::cout
+          << std::left << std::setw(12) << "Median"
+          << std::left << std::setw(12) << "Std dev"
+          << std::left << std::setw(12) << "P5"
+          << std::left << std::setw(12) << "P95"
+          << std::left << std::setw(12) << "P99"
+          << std::left << std::setw(24) << "95% CI (median)";
+      std::cout << std::endl << std::fixed;
+    }
+    std::cout
+      << std::left << std::setw(16) << chain.bytes()
+      << std::left << std::setw(12) << std::setprecision(2) << ns * stats.min
+      << std::left << std::setw(12) << std::setprecision(2) << ns * stats.max
+      << std::left << std::setw(12) << std::setprecision(2) << ns * stats.mean;
+    if (output_stats)
+    {
+      std::ostringstream ci;
+      ci << std::fixed << std::setprecision(2) << "[" << ns * stats.ci_low << ", " << ns * stats.ci_high << "]";
+      std::cout
+        << std::left << std::setw(12) << std::setprecision(2) << ns * stats.median
+        << std::left << std::setw(12) << std::setprecision(2) << ns * stats.stddev
+        << std::left << std::setw(12) << std::setprecision(2) << ns * stats.p5
+        << std::left << std::setw(12) << std::setprecision(2) << ns * stats.p95
+        << std::left << std::setw(12) << std::setprecision(2) << ns * stats.p99
+        << std::left << std::setw(24) << ci.str();
+    }
+    std::cout << std::endl;
+  }
+
+  if (counters && counters->available())
+    print_counters(*counters, {"Latency"}, {accesses * PointerChain::line_size});
+}
 
-    std::vector<std::string> labels;
-    std::vector<size_t> sizes;
+// The CPU for the loaded latency probe: the last one the process may use that no worker is pinned to,
+// or the last one the process may use if the workers cover them all (or are not pinned)
+int probe_cpu(bool& shared)
+{
+  const AffinityConfig& config = affinity_config();
+  std::vector<int> allowed = config.process_cpus.empty() ? current_cpus() : config.process_cpus;
+  shared = true;
+  if (allowed.empty())
+    return -1;
+  if (config.worker_cpus.empty())
+    return allowed.back();
+  for (auto cpu = allowed.rbegin(); cpu != allowed.rend(); ++cpu)
+  {
+    bool used = false;
+    for (const std::vector<int>& cpus : config.worker_cpus)
+      used = used || std::find(cpus.begin(), cpus.end(), *cpu) != cpus.end();
+    if (!used)
+    {
+      shared = false;
+      return *cpu;
+    }
+  }
+  return allowed.back();
+}
+
+// Measures latency under load: a probe thread chases a pointer chain the size of one array while
+// the workers run the selected kernel num_times at each level of throttling, and then with the
+// workers idle. The kernels cannot be throttled from within, so the workers wait between calls for
+// a multiple of the kernel's own runtime, and each level reports the mean latency seen by the
+// probe against the bandwidth achieved over the level including the waits.
+template <typename T>
+void run_loaded_latency(Stream<T> *stream)
+{
+  // Waits after each call, as multiples of the runtime of one call
+  const std::vector<double> delays = {0.0, 0.25, 0.5, 1.0, 2.0, 4.0, 8.0};
+  const bool copy = loaded_kernel == "copy";
+  const size_t bytes = (copy ? 2 : 3) * sizeof(T) * ARRAY_SIZE;
+
+  stream->init_arrays(startA, startB, startC);
+  auto call = [&]
+  {
+    if (copy)
+      stream->copy();
+    else
+      stream->triad();
+  };
+
+  bool shared = false;
+  int cpu = probe_cpu(shared);
+  if (shared)
+    std::cerr << "Warning: the latency probe shares CPU " << cpu
+              << " with the workers; use --threads and --bind to leave it a CPU of its own" << std::endl;
+  // The last phase is the idle latency
+  LatencyProbe probe(ARRAY_SIZE * sizeof(T), cpu, delays.size() + 1);
+
+  // Runtime of one call, once warmed up
+  call();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  call();
+  auto t2 = std::chrono::high_resolution_clock::now();
+  const double runtime = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+
+  std::vector<double> bandwidth(delays.size() + 1, 0.0);
+  for (size_t level = 0; level < delays.size(); level++)
+  {
+    const auto wait = std::chrono::duration<double>(delays[level] * runtime);
+    probe.set_phase(level);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int k = 0; k < num_times; k++)
+    {
+      call();
+      // Spin rather than sleep, as sleeps are too coarse for short kernels
+      auto until = std::chrono::high_resolution_clock::now() + std::chrono::duration_cast<std::chrono::nanoseconds>(wait);
+      while (std::chrono::high_resolution_clock::now() < until);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    probe.set_phase(-1);
+    bandwidth[level] = num_times * bytes / std::chrono::duration_cast<std::chrono::duration<double> >(end - start).count();
+  }
+
+  // Unloaded, for as long as a call takes num_times, but at least a tenth of a second
+  probe.set_phase(delays.size());
+  std::this_thread::sleep_for(std::chrono::duration<double>(std::max(0.1, num_times * runtime)));
+  probe.stop();
+
+  if (json)
+  {
+    json->begin_object();
+    json->field("array_size", ARRAY_SIZE);
+    json->field("iterations", num_times);
+    json->field("probe_cpu", cpu);
+    json->key("loaded_latency");
+    json->begin_array();
+    for (size_t level = 0; level <= delays.size(); level++)
+    {
+      json->begin_object();
+      json->field("kernel", level < delays.size() ? loaded_kernel : std::string("idle"));
+      if (level < delays.size())
+        json->field("delay", delays[level]);
+      json->field("latency_ns", 1.0E9 * probe.latency(level));
+      json->field("bandwidth_bytes_per_sec", bandwidth[level]);
+      json->end_object();
+    }
+    json->end_array();
+    json->end_object();
+  }
+
+  const double scale = (mibibytes ? std::pow(2.0, -20.0) : 1.0E-6);
+  if (output_as_csv)
+  {
+    std::cout
+      << "function" << csv_separator
+      << "delay" << csv_separator
+      << "latency_ns" << csv_separator
+      << ((mibibytes) ? "mibytes_per_sec" : "mbytes_per_sec") << std::endl;
+    for (size_t level = 0; level <= delays.size(); level++)
+      std::cout
+        << (level < delays.size() ? loaded_kernel : "idle") << csv_separator
+        << (level < delays.size() ? delays[level] : 0.0) << csv_separator
+        << 1.0E9 * probe.latency(level) << csv_separator
+        << scale * bandwidth[level] << std::endl;
+  }
+  else
+  {
+    std::cout
+      << "Probe CPU: " << cpu << std::endl
+      << std::left << std::setw(12) << "Delay"
+      << std::left << std::setw(16) << "Latency (ns)"
+      << std::left << std::setw(12) << ((mibibytes) ? "MiBytes/sec" : "MBytes/sec")
+      << std::endl << std::fixed;
+    for (size_t level = 0; level <= delays.size(); level++)
+    {
+      std::ostringstream delay;
+      if (level < delays.size())
+        delay << std::fixed << std::setprecision(2) << delays[level];
+      else
+        delay << "idle";
+      std::cout
+        << std::left << std::setw(12) << delay.str()
+        << std::left << std::setw(16) << std::setprecision(2) << 1.0E9 * probe.latency(level)
+        << std::left << std::setw(12) << std::setprecision(3) << scale * bandwidth[level]
+        << std::endl;
+    }
+  }
+}
+
+// Records how and where the benchmark was run at the top of the --json results
+template <typename T>
+void write_json_metadata(JsonWriter& out)
+{
+  out.field("benchmark", "BabelStream");
+  out.field("version", VERSION_STRING);
+  out.field("implementation", implementation_name());
+
+  char timestamp[32];
+  std::time_t now = std::time(nullptr);
+  std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  out.field("timestamp", timestamp);
+
+  out.key("device");
+  out.begin_object();
+  out.field("index", deviceIndex);
+  out.field("name", device_name(deviceIndex));
+  out.field("driver", device_driver(deviceIndex));
+  out.end_object();
+
+  out.key("options");
+  out.begin_object();
+  out.field("precision", sizeof(T) == sizeof(float) ? "float" : "double");
+  out.field("sizeof", sizeof(T));
+  out.field("array_size", ARRAY_SIZE);
+  out.field("num_times", num_times);
+  out.field("benchmark", selection == Benchmark::All ? "all" :
+                         selection == Benchmark::Triad ? "triad" :
+                         selection == Benchmark::Latency ? "latency" :
+                         selection == Benchmark::LoadedLatency ? "loaded-latency" :
+                         selection == Benchmark::GatherScatter ? "gather-scatter" : "nstream");
+  out.field("until_stable", until_stable);
+  out.field("nontemporal", nontemporal);
+  if (use_access_order)
+    out.field("order", access_order_name());
+  out.field("persistent", persistent);
+  out.field("per_thread", per_thread);
+  out.field("energy", use_energy);
+  out.field("array_size_choice", array_size_choice);
+  out.field("verify", verify_mode == VerifyMode::Sample ? "sample" : verify_mode == VerifyMode::None ? "none" : "full");
+  if (use_schedule)
+    out.field("schedule", loop_schedule_name());
+  if (cache_resident_repeats)
+  {
+    out.field("cache_resident_repeats", cache_resident_repeats);
+    out.field("timer_frequency_hz", timer_frequency());
+  }
+  if (selection == Benchmark::GatherScatter)
+    out.field("indices", index_pattern_name(index_config));
+  out.array("sweep", sweep_sizes);
+  out.field("numa", numa_policy_name(numa_config().policy));
+  out.field("pages", page_backend_name(page_config().backend));
+  out.field("prefault", page_config().prefault);
+  out.end_object();
+
+  out.key("host");
+  out.begin_object();
+#if defined(__unix__) || defined(__APPLE__)
+  char hostname[256] = {};
+  gethostname(hostname, sizeof(hostname) - 1);
+  out.field("hostname", hostname);
+  struct utsname uts;
+  if (uname(&uts) == 0)
+  {
+    out.field("os", std::string(uts.sysname) + " " + uts.release);
+    out.field("machine", uts.machine);
+  }
+#endif
+  out.field("hardware_threads", std::thread::hardware_concurrency());
+  out.end_object();
+
+  out.key("threads");
+  out.begin_object();
+#if defined(_OPENMP)
+  out.field("omp_max_threads", omp_get_max_threads());
+#endif
+  const char *env_vars[] = {"OMP_NUM_THREADS", "OMP_PROC_BIND", "OMP_PLACES", "OMP_SCHEDULE"};
+  for (const char *name : env_vars)
+  {
+    const char *value = std::getenv(name);
+    if (value)
+      out.field(name, value);
+  }
+#if defined(__linux__)
+  // The CPUs the main thread may run on
+  out.array("affinity", current_cpus());
+#endif
+  const AffinityConfig& affinity = affinity_config();
+  if (affinity.threads)
+    out.field("threads", affinity.threads);
+  if (!affinity.bind.empty())
+    out.field("bind", affinity.bind);
+  if (!affinity.worker_cpus.empty())
+  {
+    out.key("workers");
+    out.begin_array();
+    for (const std::vector<int>& cpus : affinity.worker_cpus)
+    {
+      out.begin_array();
+      for (int cpu : cpus)
+        out.value(cpu);
+      out.end_array();
+    }
+    out.end_array();
+  }
+  out.end_object();
+
+  out.key("build");
+  out.begin_object();
+#if defined(PLUGIN_DRIVER)
+  // The implementation's own build, rather than the driver's
+  out.field("compiler", current_plugin->compiler);
+  out.field("flags", current_plugin->flags);
+#else
+  out.field("compiler", BUILD_COMPILER_STRING);
+#if defined(__VERSION__)
+  out.field("compiler_version", __VERSION__);
+#endif
+  out.field("flags", BUILD_FLAGS_STRING);
+#endif
+  out.end_object();
+}
+
+
+// Sets the number of worker threads and pins them as selected with --threads and --bind.
+// This goes through the threading runtime of the implementation where the driver can reach it,
+// and otherwise restricts the whole process, which the implementation's threads then inherit.
+void apply_affinity()
+{
+  AffinityConfig& config = affinity_config();
+  if (!config.threads && config.bind.empty())
+    return;
+  // Applied again for each implementation run by the plugin driver
+  config.worker_cpus.clear();
+
+  // The main thread is pinned to the first worker's CPU after the first call
+  if (config.process_cpus.empty())
+    config.process_cpus = current_cpus();
+  std::vector<int> allowed = config.process_cpus;
+  int workers = config.threads;
+  if (!workers)
+  {
+#if defined(_OPENMP)
+    workers = omp_get_max_threads();
+#else
+    workers = allowed.empty() ? 1 : allowed.size();
+#endif
+  }
+
+  std::vector<int> plan;
+  if (!config.bind.empty())
+  {
+    std::string error;
+    plan = plan_affinity(config.bind, workers, allowed, error);
+    if (plan.empty())
+    {
+      std::cerr << "Cannot bind threads: " << error << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+#if defined(_OPENMP)
+  // OpenMP runtimes keep the same threads for later parallel regions of the same size,
+  // so pinning them once here holds for init_arrays and the kernels
+  omp_set_num_threads(workers);
+  config.worker_cpus.assign(workers, std::vector<int>());
+  #pragma omp parallel
+  {
+    int t = omp_get_thread_num();
+    if (!plan.empty())
+      pin_current_thread({plan[t]});
+    config.worker_cpus[t] = current_cpus();
+  }
+#elif defined(TBB)
+  // Threads are pinned as they join the arena, so the plan is what gets reported.
+  // --scaling replaces the arena for each thread count.
+  if (tbb_observer)
+    tbb_observer->observe(false);
+  delete tbb_observer;
+  delete tbb_arena;
+  tbb_observer = nullptr;
+  tbb_arena = new tbb::task_arena(workers);
+  if (!plan.empty())
+  {
+    tbb_observer = new TBBPinningObserver(*tbb_arena, plan);
+    tbb_observer->observe(true);
+    for (int cpu : plan)
+      config.worker_cpus.push_back({cpu});
+  }
+#else
+  // The implementation's threads cannot be reached individually, so confine the process
+  // to the CPUs the workers would have had and let them inherit that
+  std::vector<int> cpus = plan;
+  if (cpus.empty())
+  {
+    std::string error;
+    cpus = plan_affinity("compact", std::min<int>(workers, allowed.size()), allowed, error);
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  if (!pin_current_thread(cpus))
+    std::cerr << "Warning: could not set the affinity of the process" << std::endl;
+  config.worker_cpus.push_back(current_cpus());
+#endif
+
+  if (!output_as_csv)
+  {
+    std::cout << "Threads: " << workers;
+    if (!config.bind.empty())
+      std::cout << " (bind " << config.bind << ")";
+    std::cout << std::endl;
+#if !defined(_OPENMP) && !defined(TBB)
+    std::cout << "  process:";
+    for (int cpu : config.worker_cpus[0])
+      std::cout << " " << cpu;
+    std::cout << std::endl;
+#else
+    for (size_t t = 0; t < config.worker_cpus.size(); t++)
+    {
+      std::cout << "  worker " << t << ":";
+      for (int cpu : config.worker_cpus[t])
+        std::cout << " " << cpu;
+      std::cout << std::endl;
+    }
+#endif
+  }
+}
+
+// Runs f on the threads selected with --threads and --bind
+template <typename F>
+void with_threads(F f)
+{
+#if defined(TBB)
+  if (tbb_arena)
+  {
+    tbb_arena->execute(f);
+    return;
+  }
+#endif
+  f();
+}
+
+// Prints the best bandwidth of each kernel at each thread count of --scaling, and the parallel
+// efficiency: the bandwidth per thread relative to that at the smallest count
+void print_scaling(const std::vector<std::vector<std::pair<std::string, double>>>& results)
+{
+  const double scale = (mibibytes) ? std::pow(2.0, -20.0) : 1.0E-6;
+  const std::vector<std::pair<std::string, double>>& base = results.front();
+
+  if (output_as_csv)
+  {
+    std::cout
+      << "threads" << csv_separator
+      << "function" << csv_separator
+      << ((mibibytes) ? "max_mibytes_per_sec" : "max_mbytes_per_sec") << csv_separator
+      << "efficiency" << std::endl;
+  }
+  else
+  {
+    std::cout
+      << std::endl
+      << "Scaling (best " << ((mibibytes) ? "MiBytes/sec" : "MBytes/sec")
+      << " and parallel efficiency)" << std::endl
+      << std::left << std::setw(12) << "Threads";
+    for (const std::pair<std::string, double>& kernel : base)
+      std::cout << std::left << std::setw(20) << kernel.first;
+    std::cout << std::endl;
+  }
+
+  for (size_t r = 0; r < results.size(); r++)
+  {
+    const int threads = scaling_min + r;
+    if (!output_as_csv)
+      std::cout << std::left << std::setw(12) << threads;
+    for (size_t k = 0; k < base.size() && k < results[r].size(); k++)
+    {
+      double efficiency = (results[r][k].second / threads) / (base[k].second / scaling_min);
+      if (output_as_csv)
+      {
+        std::cout
+          << threads << csv_separator
+          << results[r][k].first << csv_separator
+          << scale * results[r][k].second << csv_separator
+          << efficiency << std::endl;
+      }
+      else
+      {
+        std::ostringstream cell;
+        cell << std::fixed << std::setprecision(1) << scale * results[r][k].second
+             << " " << std::setprecision(0) << 100.0 * efficiency << "%";
+        std::cout << std::left << std::setw(20) << cell.str();
+      }
+    }
+    if (!output_as_csv)
+      std::cout << std::endl;
+  }
+}
+
+// Runs the benchmark at each thread count of --scaling on the same arrays, pinning the threads
+// again for each count
+template <typename T>
+void run_scaling(Stream<T> *stream)
+{
+  // The pages are first touched by all the threads, as in a run at the largest count
+  with_threads([&] { stream->init_arrays(startA, startB, startC); });
+
+  std::vector<std::vector<std::pair<std::string, double>>> results;
+  for (int threads = scaling_min; threads <= scaling_max; threads++)
+  {
+    affinity_config().threads = threads;
+    apply_affinity();
+    best_bandwidths.clear();
+    with_threads([&] { run_benchmark<T>(stream, !output_as_csv || threads == scaling_min || use_perf); });
+    results.push_back(best_bandwidths);
+  }
+  print_scaling(results);
+}
+
+#if defined(__linux__)
+// Prints the node bandwidth of --processes, counting the bytes of every process over the time
+// from the first start to the last end of each iteration, and then the best bandwidth each
+// process reached on its own. node[k][i] is that time for iteration i of kernel k, and
+// times[p][k][i] the runtime of process p.
+void print_processes(const std::vector<std::vector<double>>& node,
+                     const std::vector<std::vector<std::vector<double>>>& times,
+                     const std::vector<std::string>& labels, const std::vector<size_t>& sizes,
+                     size_t element_size)
+{
+  const double scale = (mibibytes) ? std::pow(2.0, -20.0) : 1.0E-6;
+  const size_t nprocs = times.size();
+
+  if (output_as_csv)
+  {
+    std::cout
+      << "function" << csv_separator
+      << "processes" << csv_separator
+      << "num_times" << csv_separator
+      << "n_elements" << csv_separator
+      << "sizeof" << csv_separator
+      << ((mibibytes) ? "max_mibytes_per_sec" : "max_mbytes_per_sec") << csv_separator
+      << "min_runtime" << csv_separator
+      << "max_runtime" << csv_separator
+      << "avg_runtime";
+    if (output_stats)
+      std::cout
+        << csv_separator << "median_runtime"
+        << csv_separator << "stddev_runtime"
+        << csv_separator << "p5_runtime"
+        << csv_separator << "p95_runtime"
+        << csv_separator << "p99_runtime"
+        << csv_separator << "ci_low_runtime"
+        << csv_separator << "ci_high_runtime";
+    std::cout << std::endl;
+  }
+  else
+  {
+    std::cout
+      << std::left << std::setw(12) << "Function"
+      << std::left << std::setw(12) << ((mibibytes) ? "MiBytes/sec" : "MBytes/sec")
+      << std::left << std::setw(12) << "Min (sec)"
+      << std::left << std::setw(12) << "Max"
+      << std::left << std::setw(12) << "Average";
+    if (output_stats)
+      std::cout
+        << std::left << std::setw(12) << "Median"
+        << std::left << std::setw(12) << "Std dev"
+        << std::left << std::setw(12) << "P5"
+        << std::left << std::setw(12) << "P95"
+        << std::left << std::setw(12) << "P99"
+        << std::left << std::setw(24) << "95% CI (median)";
+    std::cout
+      << std::endl
+      << std::fixed;
+  }
+
+  for (size_t k = 0; k < labels.size(); k++)
+  {
+    // Summarise the runtimes; ignore the first result
+    TimingStats stats = compute_stats(node[k].begin()+1, node[k].end());
+    const double bytes = static_cast<double>(nprocs) * sizes[k];
+    best_bandwidths.push_back(std::make_pair(labels[k], bytes / stats.min));
+
+    if (output_as_csv)
+    {
+      std::cout
+        << labels[k] << csv_separator
+        << nprocs << csv_separator
+        << num_times << csv_separator
+        << ARRAY_SIZE << csv_separator
+        << element_size << csv_separator
+        << scale * bytes / stats.min << csv_separator
+        << stats.min << csv_separator
+        << stats.max << csv_separator
+        << stats.mean;
+      if (output_stats)
+        std::cout
+          << csv_separator << stats.median
+          << csv_separator << stats.stddev
+          << csv_separator << stats.p5
+          << csv_separator << stats.p95
+          << csv_separator << stats.p99
+          << csv_separator << stats.ci_low
+          << csv_separator << stats.ci_high;
+      std::cout << std::endl;
+    }
+    else
+    {
+      std::cout
+        << std::left << std::setw(12) << labels[k]
+        << std::left << std::setw(12) << std::setprecision(3) << scale * bytes / stats.min
+        << std::left << std::setw(12) << std::setprecision(5) << stats.min
+        << std::left << std::setw(12) << std::setprecision(5) << stats.max
+        << std::left << std::setw(12) << std::setprecision(5) << stats.mean;
+      if (output_stats)
+      {
+        std::ostringstream ci;
+        ci << std::fixed << std::setprecision(5) << "[" << stats.ci_low << ", " << stats.ci_high << "]";
+        std::cout
+          << std::left << std::setw(12) << std::setprecision(5) << stats.median
+          << std::left << std::setw(12) << std::setprecision(5) << stats.stddev
+          << std::left << std::setw(12) << std::setprecision(5) << stats.p5
+          << std::left << std::setw(12) << std::setprecision(5) << stats.p95
+          << std::left << std::setw(12) << std::setprecision(5) << stats.p99
+          << std::left << std::setw(24) << ci.str();
+      }
+      std::cout << std::endl;
+    }
+  }
+
+  if (output_as_csv)
+  {
+    std::cout
+      << "process" << csv_separator
+      << "function" << csv_separator
+      << ((mibibytes) ? "max_mibytes_per_sec" : "max_mbytes_per_sec") << std::endl;
+  }
+  else
+  {
+    std::cout
+      << std::endl
+      << "Per process (best " << ((mibibytes) ? "MiBytes/sec" : "MBytes/sec") << ")" << std::endl
+      << std::left << std::setw(12) << "Process";
+    for (const std::string& label : labels)
+      std::cout << std::left << std::setw(12) << label;
+    std::cout << std::endl;
+  }
+
+  for (size_t p = 0; p < nprocs; p++)
+  {
+    if (!output_as_csv)
+      std::cout << std::left << std::setw(12) << p;
+    for (size_t k = 0; k < labels.size(); k++)
+    {
+      double best = *std::min_element(times[p][k].begin() + 1, times[p][k].end());
+      if (output_as_csv)
+        std::cout << p << csv_separator << labels[k] << csv_separator << scale * sizes[k] / best << std::endl;
+      else
+        std::cout << std::left << std::setw(12) << std::setprecision(1) << scale * sizes[k] / best;
+    }
+    if (!output_as_csv)
+      std::cout << std::endl;
+  }
+}
+
+// Forks one worker process for each of --processes, each pinned to its own share of the CPUs
+// and running the kernels on a Stream<T> of its own, as one rank of an MPI job would. The workers
+// start every kernel together and hand their timings back through shared memory.
+// This runs before the parent has started any threads, which the workers could not inherit.
+template <typename T>
+void run_processes()
+{
+  const size_t kernels = 5;
+  ProcessGroup group(processes, kernels, num_times);
+  if (!group.available())
+  {
+    std::cerr << "Could not set up the shared memory for --processes" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // Contiguous groups of CPUs in compact order. Processes sharing a CPU would take turns
+  // rather than load the memory system together, so each needs one of its own.
+  std::vector<int> allowed = order_cpus_compact(current_cpus());
+  if (processes > static_cast<int>(allowed.size()))
+  {
+    std::cerr << "--processes " << processes << " needs a CPU for each process, but only "
+              << allowed.size() << " are available" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::vector<std::vector<int>> cpus(processes);
+  for (int p = 0; p < processes; p++)
+    cpus[p].assign(allowed.begin() + p * allowed.size() / processes,
+                   allowed.begin() + (p + 1) * allowed.size() / processes);
+
+  if (!output_as_csv)
+  {
+    std::cout << "Processes: " << processes << std::endl;
+    for (int p = 0; p < processes; p++)
+    {
+      std::cout << "  process " << p << ":";
+      for (int cpu : cpus[p])
+        std::cout << " " << cpu;
+      std::cout << std::endl;
+    }
+  }
+
+  // Nothing buffered before the fork may be printed again by the workers
+  std::cout.flush();
+  std::cerr.flush();
+  std::vector<pid_t> pids;
+  for (int p = 0; p < processes; p++)
+  {
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      std::cerr << "Could not fork for --processes" << std::endl;
+      for (pid_t child : pids)
+        kill(child, SIGKILL);
+      exit(EXIT_FAILURE);
+    }
+    if (pid == 0)
+    {
+      // Only the parent reports; errors and failed validations still reach stderr
+      if (!freopen("/dev/null", "w", stdout))
+        std::cout.setstate(std::ios_base::badbit);
+      group.join(p);
+      pin_current_thread(cpus[p]);
+      if (!affinity_config().threads)
+        affinity_config().threads = cpus[p].size();
+      apply_affinity();
+
+      Stream<T> *stream = make_stream<T>(ARRAY_SIZE);
+      configure_stream(stream);
+      T sum{};
+      with_threads([&]
+      {
+        stream->init_arrays(startA, startB, startC);
+        process_group = &group;
+        run_all<T>(stream, sum);
+        process_group = nullptr;
+
+        ArrayCheck check;
+        if (verify_mode != VerifyMode::None && !check_solution<T>(stream, num_times, sum, check))
+          std::cerr << "Process " << p << " failed validation" << std::endl;
+      });
+      delete stream;
+
+      std::cerr.flush();
+      _exit(EXIT_SUCCESS);
+    }
+    pids.push_back(pid);
+  }
+
+  // A worker that fails leaves the others waiting at the barrier, so they are stopped
+  bool failed = false;
+  for (int remaining = processes; remaining > 0; remaining--)
+  {
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0)
+      break;
+    if (!failed && (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS))
+    {
+      failed = true;
+      std::cerr << "Process " << std::find(pids.begin(), pids.end(), pid) - pids.begin()
+                << " failed, stopping the others" << std::endl;
+      for (pid_t child : pids)
+        if (child != pid)
+          kill(child, SIGKILL);
+    }
+  }
+  if (failed)
+    exit(EXIT_FAILURE);
+
+  // The node finishes an iteration when its last process does, timed from when the first started
+  std::vector<std::vector<double>> node(kernels, std::vector<double>(num_times));
+  std::vector<std::vector<std::vector<double>>> times(processes, std::vector<std::vector<double>>(kernels));
+  for (size_t k = 0; k < kernels; k++)
+  {
+    for (unsigned int i = 0; i < num_times; i++)
+    {
+      double first = group.start_time(0, k, i);
+      double last = group.end_time(0, k, i);
+      for (int p = 0; p < processes; p++)
+      {
+        first = std::min(first, group.start_time(p, k, i));
+        last = std::max(last, group.end_time(p, k, i));
+        times[p][k].push_back(group.end_time(p, k, i) - group.start_time(p, k, i));
+      }
+      node[k][i] = last - first;
+    }
+  }
+
+  std::vector<std::string> labels = {"Copy", "Mul", "Add", "Triad", "Dot"};
+  std::vector<size_t> sizes = {
+    2 * sizeof(T) * ARRAY_SIZE,
+    2 * sizeof(T) * ARRAY_SIZE,
+    3 * sizeof(T) * ARRAY_SIZE,
+    3 * sizeof(T) * ARRAY_SIZE,
+    2 * sizeof(T) * ARRAY_SIZE};
+  print_processes(node, times, labels, sizes, sizeof(T));
+}
+#endif
+
+// Generic run routine
+// Runs the kernel(s) and prints output.
+template <typename T>
+void run()
+{
+  std::streamsize ss = std::cout.precision();
+
+  if (!output_as_csv)
+  {
+    if (until_stable)
+      std::cout << "Running kernels at least " << num_times << " times until the median runtimes are within "
+                << 100.0 * stable_ci_width << "% (95% CI), for at most " << stable_time_budget << " s" << std::endl;
+    else if (selection == Benchmark::All)
+      std::cout << "Running kernels " << num_times << " times" << std::endl;
+    else if (selection == Benchmark::Triad)
+    {
+      std::cout << "Running triad " << num_times << " times" << std::endl;
+      std::cout << "Number of elements: " << ARRAY_SIZE << std::endl;
+    }
+    else if (selection == Benchmark::Latency)
+      std::cout << "Running pointer chase " << num_times << " times of " << latency_accesses
+                << " accesses per size" << std::endl;
+    else if (selection == Benchmark::LoadedLatency)
+      std::cout << "Running " << loaded_kernel << " " << num_times
+                << " times at each load level, with a pointer chase on another thread" << std::endl;
+    else if (selection == Benchmark::GatherScatter)
+      std::cout << "Running gather and scatter " << num_times << " times with "
+                << index_pattern_name(index_config) << " indices" << std::endl;
+
+    if (cache_resident_repeats)
+    {
+      std::ostringstream ghz;
+      ghz << std::fixed << std::setprecision(3) << 1.0E-9 * timer_frequency();
+      std::cout << "Cache-resident: " << cache_resident_repeats << " passes per kernel call, timed at "
+                << ghz.str() << " GHz" << std::endl;
+    }
+
+    if (use_schedule)
+      std::cout << "Loop schedule: " << loop_schedule_name() << std::endl;
+
+    if (numa_config().policy != NumaPolicy::Default)
+      std::cout << "NUMA policy: " << numa_policy_name(numa_config().policy) << std::endl;
+
+    if (page_config().backend != PageBackend::Default || page_config().prefault)
+      std::cout << "Pages: " << page_backend_name(page_config().backend)
+                << (page_config().prefault ? ", prefaulted" : "") << std::endl;
+
+    if (!sweep_sizes.empty())
+      std::cout << "Sweeping " << sweep_sizes.size() << " array sizes from "
+                << sweep_sizes.front() << " to " << sweep_sizes.back() << " elements" << std::endl;
+
+
+    if (sizeof(T) == sizeof(float))
+      std::cout << "Precision: float" << std::endl;
+    else
+      std::cout << "Precision: double" << std::endl;
+
+
+    if (mibibytes)
+    {
+      // MiB = 2^20
+      std::cout << std::setprecision(1) << std::fixed
+                << "Array size: " << ARRAY_SIZE*sizeof(T)*std::pow(2.0, -20.0) << " MiB"
+                << " (=" << ARRAY_SIZE*sizeof(T)*std::pow(2.0, -30.0) << " GiB)" << std::endl;
+      std::cout << "Total size: " << 3.0*ARRAY_SIZE*sizeof(T)*std::pow(2.0, -20.0) << " MiB"
+                << " (=" << 3.0*ARRAY_SIZE*sizeof(T)*std::pow(2.0, -30.0) << " GiB)" << std::endl;
+    }
+    else
+    {
+      // MB = 10^6
+      std::cout << std::setprecision(1) << std::fixed
+                << "Array size: " << ARRAY_SIZE*sizeof(T)*1.0E-6 << " MB"
+                << " (=" << ARRAY_SIZE*sizeof(T)*1.0E-9 << " GB)" << std::endl;
+      std::cout << "Total size: " << 3.0*ARRAY_SIZE*sizeof(T)*1.0E-6 << " MB"
+                << " (=" << 3.0*ARRAY_SIZE*sizeof(T)*1.0E-9 << " GB)" << std::endl;
+    }
+    std::cout.precision(ss);
+    if (!array_size_choice.empty())
+      std::cout << "Array size chosen for " << array_size_choice << std::endl;
+
+  }
+
+#if defined(__linux__)
+  if (processes)
+  {
+    run_processes<T>();
+    return;
+  }
+#endif
+
+  // Before the implementation is constructed, as some start their threads there
+  apply_affinity();
+
+  // When sweeping, ARRAY_SIZE is the largest size so the arrays are allocated only once.
+  // The latency benchmark does not use the implementation, only host memory of its own.
+  Stream<T> *stream = nullptr;
+  if (selection != Benchmark::Latency)
+    stream = make_stream<T>(ARRAY_SIZE);
+  placement_reported = false;
+
+  if (stream)
+    configure_stream(stream);
+
+  std::ofstream json_out;
+  if (!json_file.empty())
+  {
+    json_out.open(json_file);
+    if (!json_out)
+    {
+      std::cerr << "Could not open " << json_file << " for writing" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    json = new JsonWriter(json_out);
+    json->begin_object();
+    write_json_metadata<T>(*json);
+    json->key("runs");
+    json->begin_array();
+  }
+
+  if (scaling_max)
+    run_scaling<T>(stream);
+  else with_threads([&]
+  {
+    if (selection == Benchmark::Latency)
+    {
+      for (size_t i = 0; i < sweep_sizes.size(); i++)
+      {
+        ARRAY_SIZE = sweep_sizes[i];
+        run_latency<T>(i == 0 || use_perf);
+      }
+    }
+    else if (selection == Benchmark::LoadedLatency)
+    {
+      run_loaded_latency<T>(stream);
+    }
+    else if (sweep_sizes.empty())
+    {
+      run_benchmark<T>(stream, true);
+    }
+    else
+    {
+      for (size_t i = 0; i < sweep_sizes.size(); i++)
+      {
+        ARRAY_SIZE = sweep_sizes[i];
+        if (!stream->set_active_size(ARRAY_SIZE))
+        {
+          std::cerr << "Array size " << ARRAY_SIZE << " of the sweep is not supported by the "
+                    << implementation_name() << " implementation" << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        // The counters table follows each size, so the timings need their header again
+        run_benchmark<T>(stream, i == 0 || use_perf);
+      }
+    }
+  });
+
+  if (json)
+  {
+    json->end_array();
+    json->end_object();
+    delete json;
+    json = nullptr;
+  }
+
+  delete stream;
+
+}
+
+#if defined(PLUGIN_DRIVER)
+// Loads an implementation built as a plugin library, keeping it loaded until the driver exits
+void load_plugin(const char *file)
+{
+  void *handle = dlopen(file, RTLD_NOW | RTLD_LOCAL);
+  if (!handle)
+  {
+    std::cerr << "Could not load plugin " << file << ": " << dlerror() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  StreamPluginEntry entry = reinterpret_cast<StreamPluginEntry>(dlsym(handle, STREAM_PLUGIN_SYMBOL));
+  const StreamPlugin *plugin = entry ? entry() : nullptr;
+  if (!plugin || plugin->version != STREAM_PLUGIN_VERSION)
+  {
+    std::cerr << file << " is not a BabelStream plugin of version " << STREAM_PLUGIN_VERSION << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  plugins.push_back(plugin);
+  plugin_files.push_back(file);
+}
+
+// Runs the current implementation in a child process, which prints its results as usual and
+// sends its best bandwidths back through a pipe. Returns false if the child failed.
+bool run_forked(std::vector<std::pair<std::string, double>>& bandwidths)
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    std::cerr << "Could not create a pipe for --fork" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // Nothing buffered before the fork may be printed twice
+  std::cout.flush();
+  std::cerr.flush();
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    std::cerr << "Could not fork for --fork" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (pid == 0)
+  {
+    close(fds[0]);
+    if (use_float)
+      run<float>();
+    else
+      run<double>();
+    std::ostringstream out;
+    out << std::setprecision(17);
+    for (const std::pair<std::string, double>& result : best_bandwidths)
+      out << result.first << '\t' << result.second << '\n';
+    std::string message = out.str();
+    for (size_t written = 0; written < message.size();)
+    {
+      ssize_t n = write(fds[1], message.data() + written, message.size() - written);
+      if (n <= 0)
+        break;
+      written += n;
+    }
+    std::cout.flush();
+    _exit(EXIT_SUCCESS);
+  }
+
+  close(fds[1]);
+  std::string message;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+    message.append(buffer, n);
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+    return false;
+
+  std::istringstream in(message);
+  std::string label, value;
+  while (std::getline(in, label, '\t') && std::getline(in, value))
+    bandwidths.push_back(std::make_pair(label, std::stod(value)));
+  return true;
+}
+
+// Prints the best bandwidth of every kernel of every implementation side by side
+void print_comparison(const std::vector<std::vector<std::pair<std::string, double>>>& results)
+{
+  // Kernels in the order they were first run; implementations may not all run the same ones
+  std::vector<std::string> labels;
+  for (const std::vector<std::pair<std::string, double>>& bandwidths : results)
+    for (const std::pair<std::string, double>& result : bandwidths)
+      if (std::find(labels.begin(), labels.end(), result.first) == labels.end())
+        labels.push_back(result.first);
+
+  // Columns are named by implementation, or by file where two plugins are the same implementation
+  std::vector<std::string> columns;
+  for (size_t p = 0; p < plugins.size(); p++)
+  {
+    bool shared = false;
+    for (size_t q = 0; q < plugins.size(); q++)
+      if (q != p && !std::string(plugins[q]->implementation).compare(plugins[p]->implementation))
+        shared = true;
+    columns.push_back(shared ? plugin_files[p] : plugins[p]->implementation);
+  }
+
+  const double scale = mibibytes ? std::pow(2.0, -20.0) : 1.0E-6;
+  size_t label_width = 12;
+  for (const std::string& label : labels)
+    label_width = std::max(label_width, label.size() + 2);
+
+  std::streamsize ss = std::cout.precision();
+  if (output_as_csv)
+  {
+    std::cout << "function";
+    for (const std::string& column : columns)
+      std::cout << csv_separator << column;
+    std::cout << std::endl;
+  }
+  else
+  {
+    std::cout
+      << std::endl
+      << "Comparison (best " << ((mibibytes) ? "MiBytes/sec" : "MBytes/sec") << ")" << std::endl
+      << std::left << std::setw(label_width) << "Function";
+    for (const std::string& column : columns)
+      std::cout << std::left << std::setw(std::max<size_t>(16, column.size() + 2)) << column;
+    std::cout << std::endl << std::fixed << std::setprecision(3);
+  }
+
+  for (const std::string& label : labels)
+  {
+    if (output_as_csv)
+      std::cout << label;
+    else
+      std::cout << std::left << std::setw(label_width) << label;
+    for (size_t p = 0; p < results.size(); p++)
+    {
+      std::ostringstream cell;
+      cell << std::fixed << std::setprecision(3) << "-";
+      for (const std::pair<std::string, double>& result : results[p])
+        if (result.first == label)
+        {
+          cell.str("");
+          cell << scale * result.second;
+        }
+      if (output_as_csv)
+        std::cout << csv_separator << cell.str();
+      else
+        std::cout << std::left << std::setw(std::max<size_t>(16, columns[p].size() + 2)) << cell.str();
+    }
+    std::cout << std::endl;
+  }
+  std::cout.precision(ss);
+}
+
+// Runs every implementation loaded with --plugin in turn, in this process or each in a child
+// process with --fork, then prints their best bandwidths side by side
+void run_plugins()
+{
+  std::vector<std::vector<std::pair<std::string, double>>> results;
+  for (size_t p = 0; p < plugins.size(); p++)
+  {
+    current_plugin = plugins[p];
+    if (!output_as_csv)
+      std::cout << std::endl << "Implementation: " << current_plugin->implementation
+                << " (" << plugin_files[p] << ")" << std::endl;
+
+    best_bandwidths.clear();
+    if (!fork_plugins)
+    {
+      if (use_float)
+        run<float>();
+      else
+        run<double>();
+      results.push_back(best_bandwidths);
+    }
+    else
+    {
+      std::vector<std::pair<std::string, double>> bandwidths;
+      if (!run_forked(bandwidths))
+        std::cerr << "Warning: the " << current_plugin->implementation
+                  << " implementation did not complete" << std::endl;
+      results.push_back(bandwidths);
+    }
+  }
+  current_plugin = nullptr;
+
+  if (plugins.size() > 1)
+    print_comparison(results);
+}
+#endif
+
+
+// Finds the mean absolute error of each array against the expected values, in place by the
+// implementation where it can, then directly from the arrays where they are in host memory, and
+// otherwise by reading the arrays back a chunk at a time so the host never holds more than a
+// chunk of each. With --verify sample, about verify_samples elements of each array are checked.
+template <typename T>
+ArrayCheck check_arrays(Stream<T> *stream, const T goldA, const T goldB, const T goldC)
+{
+  ArrayCheck check = {};
+  const bool sample = verify_mode == VerifyMode::Sample && ARRAY_SIZE > verify_samples;
+  const intptr_t stride = sample ? ARRAY_SIZE / verify_samples : 1;
+
+  double errA, errB, errC;
+  auto t1 = std::chrono::high_resolution_clock::now();
+  if (stream->verify(goldA, goldB, goldC, stride, errA, errB, errC))
+  {
+    auto t2 = std::chrono::high_resolution_clock::now();
+    check.errA = errA;
+    check.errB = errB;
+    check.errC = errC;
+    check.bytes = 3.0 * sizeof(T) * ((ARRAY_SIZE + stride - 1) / stride);
+    check.seconds = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+    return check;
+  }
 
-    if (selection == Benchmark::All)
-    {
-      labels = {"Copy", "Mul", "Add", "Triad", "Dot"};
-      sizes = {
-        2 * sizeof(T) * ARRAY_SIZE,
-        2 * sizeof(T) * ARRAY_SIZE,
-        3 * sizeof(T) * ARRAY_SIZE,
-        3 * sizeof(T) * ARRAY_SIZE,
-        2 * sizeof(T) * ARRAY_SIZE};
-    } else if (selection == Benchmark::Nstream)
+  long double sumA = 0.0, sumB = 0.0, sumC = 0.0;
+  intptr_t elements = 0;
+  auto accumulate = [&](const T *a, const T *b, const T *c, intptr_t n, intptr_t step)
+  {
+    for (intptr_t i = 0; i < n; i += step)
     {
-      labels = {"Nstream"};
-      sizes = {4 * sizeof(T) * ARRAY_SIZE };
+      sumA += std::fabs(a[i] - goldA);
+      sumB += std::fabs(b[i] - goldB);
+      sumC += std::fabs(c[i] - goldC);
+      elements++;
     }
+  };
 
-    for (int i = 0; i < timings.size(); ++i)
-    {
-      // Get min/max; ignore the first result
-      auto minmax = std::minmax_element(timings[i].begin()+1, timings[i].end());
+  HostArray<T> viewA, viewB, viewC;
+  if (stream->host_arrays(viewA, viewB, viewC))
+  {
+    accumulate(viewA.data, viewB.data, viewC.data, viewA.size, stride);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    check.errA = sumA / elements;
+    check.errB = sumB / elements;
+    check.errC = sumC / elements;
+    check.bytes = 3.0 * sizeof(T) * elements;
+    check.seconds = std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+    return check;
+  }
 
-      // Calculate average; ignore the first result
-      double average = std::accumulate(timings[i].begin()+1, timings[i].end(), 0.0) / (double)(num_times - 1);
+  check.read_back = true;
 
-      // Display results
-      if (output_as_csv)
-      {
-        std::cout
-          << labels[i] << csv_separator
-          << num_times << csv_separator
-          << ARRAY_SIZE << csv_separator
-          << sizeof(T) << csv_separator
-          << ((mibibytes) ? std::pow(2.0, -20.0) : 1.0E-6) * sizes[i] / (*minmax.first) << csv_separator
-          << *minmax.first << csv_separator
-          << *minmax.second << csv_separator
-          << average
-          << std::endl;
-      }
-      else
-      {
-        std::cout
-          << std::left << std::setw(12) << labels[i]
-          << std::left << std::setw(12) << std::setprecision(3) << 
-            ((mibibytes) ? std::pow(2.0, -20.0) : 1.0E-6) * sizes[i] / (*minmax.first)
-          << std::left << std::setw(12) << std::setprecision(5) << *minmax.first
-          << std::left << std::setw(12) << std::setprecision(5) << *minmax.second
-          << std::left << std::setw(12) << std::setprecision(5) << average
-          << std::endl;
-      }
-    }
-  } else if (selection == Benchmark::Triad)
+  const intptr_t chunk = sample ? verify_sample_chunk : std::min(ARRAY_SIZE, verify_chunk);
+  const intptr_t chunks = sample ? verify_samples / verify_sample_chunk : (ARRAY_SIZE + chunk - 1) / chunk;
+  std::vector<T> a, b, c;
+  bool ranged = true;
+  for (intptr_t k = 0; k < chunks && ranged; k++)
   {
-    // Display timing results
-    double total_bytes = 3 * sizeof(T) * ARRAY_SIZE * num_times;
-    double bandwidth = ((mibibytes) ? std::pow(2.0, -30.0) : 1.0E-9) * (total_bytes / timings[0][0]);
-
-    if (output_as_csv)
-    {
-      std::cout
-        << "function" << csv_separator
-        << "num_times" << csv_separator
-        << "n_elements" << csv_separator
-        << "sizeof" << csv_separator
-        << ((mibibytes) ? "gibytes_per_sec" : "gbytes_per_sec") << csv_separator
-        << "runtime"
-        << std::endl;
-      std::cout
-        << "Triad" << csv_separator
-        << num_times << csv_separator
-        << ARRAY_SIZE << csv_separator
-        << sizeof(T) << csv_separator
-        << bandwidth << csv_separator
-        << timings[0][0]
-        << std::endl;
-    }
-    else
+    const intptr_t begin = sample ? k * (ARRAY_SIZE / chunks) : k * chunk;
+    const intptr_t n = std::min(chunk, ARRAY_SIZE - begin);
+    a.resize(n);
+    b.resize(n);
+    c.resize(n);
+    auto r1 = std::chrono::high_resolution_clock::now();
+    ranged = stream->read_range(begin, a, b, c);
+    auto r2 = std::chrono::high_resolution_clock::now();
+    if (ranged)
     {
-      std::cout
-        << "--------------------------------"
-        << std::endl << std::fixed
-        << "Runtime (seconds): " << std::left << std::setprecision(5)
-        << timings[0][0] << std::endl
-        << "Bandwidth (" << ((mibibytes) ? "GiB/s" : "GB/s") << "):  "
-        << std::left << std::setprecision(3)
-        << bandwidth << std::endl;
+      check.bytes += 3.0 * sizeof(T) * n;
+      check.seconds += std::chrono::duration_cast<std::chrono::duration<double> >(r2 - r1).count();
+      accumulate(a.data(), b.data(), c.data(), n, 1);
     }
   }
 
-  delete stream;
+  if (!ranged)
+  {
+    // Only whole arrays can be read back
+    sumA = sumB = sumC = 0.0;
+    elements = 0;
+    a.assign(ARRAY_SIZE, T{});
+    b.assign(ARRAY_SIZE, T{});
+    c.assign(ARRAY_SIZE, T{});
+    auto r1 = std::chrono::high_resolution_clock::now();
+    stream->read_arrays(a, b, c);
+    auto r2 = std::chrono::high_resolution_clock::now();
+    check.bytes = 3.0 * sizeof(T) * ARRAY_SIZE;
+    check.seconds = std::chrono::duration_cast<std::chrono::duration<double> >(r2 - r1).count();
+    accumulate(a.data(), b.data(), c.data(), ARRAY_SIZE, stride);
+  }
 
+  check.errA = sumA / elements;
+  check.errB = sumB / elements;
+  check.errC = sumC / elements;
+  return check;
 }
 
-
 template <typename T>
-void check_solution(const unsigned int ntimes, std::vector<T>& a, std::vector<T>& b, std::vector<T>& c, T& sum)
+bool check_solution(Stream<T> *stream, const unsigned int ntimes, T& sum, ArrayCheck& check)
 {
   // Generate correct solution
   T goldA = startA;
@@ -535,6 +3173,10 @@ void check_solution(const unsigned int ntimes, std::vector<T>& a, std::vector<T>
     } else if (selection == Benchmark::Nstream)
     {
       goldA += goldB + scalar * goldC;
+    } else if (selection == Benchmark::GatherScatter)
+    {
+      // The indices are a permutation and b is uniform, so both leave a equal to b
+      goldA = goldB;
     }
   }
 
@@ -542,12 +3184,10 @@ void check_solution(const unsigned int ntimes, std::vector<T>& a, std::vector<T>
   goldSum = goldA * goldB * ARRAY_SIZE;
 
   // Calculate the average error
-  long double errA = std::accumulate(a.begin(), a.end(), T{}, [&](double sum, const T val){ return sum + std::fabs(val - goldA); });
-  errA /= a.size();
-  long double errB = std::accumulate(b.begin(), b.end(), T{}, [&](double sum, const T val){ return sum + std::fabs(val - goldB); });
-  errB /= b.size();
-  long double errC = std::accumulate(c.begin(), c.end(), T{}, [&](double sum, const T val){ return sum + std::fabs(val - goldC); });
-  errC /= c.size();
+  check = check_arrays(stream, goldA, goldB, goldC);
+  long double errA = check.errA;
+  long double errB = check.errB;
+  long double errC = check.errC;
   long double errSum = std::fabs((sum - goldSum)/goldSum);
 
   long double epsi = std::numeric_limits<T>::epsilon() * 100.0;
@@ -572,6 +3212,8 @@ void check_solution(const unsigned int ntimes, std::vector<T>& a, std::vector<T>
       << "Sum was " << sum << " but should be " << goldSum
       << std::endl;
 
+  return errA <= epsi && errB <= epsi && errC <= epsi &&
+         (selection != Benchmark::All || errSum <= 1.0E-8);
 }
 
 int parseUInt(const char *str, unsigned int *output)
@@ -581,6 +3223,103 @@ int parseUInt(const char *str, unsigned int *output)
   return !strlen(next);
 }
 
+// Memory and last-level cache that the arrays of an implementation will be in, from its
+// getDeviceMemory, or from the host topology and the --numa node for arrays in host memory
+void array_memory(bool (*device_memory)(int, size_t&, size_t&), size_t& memory, size_t& cache, bool& on_device)
+{
+  on_device = device_memory(deviceIndex, memory, cache);
+  if (!on_device)
+  {
+    std::vector<int> nodes;
+    if (numa_config().policy == NumaPolicy::Bind)
+      nodes.push_back(numa_config().node);
+    memory = available_memory(nodes);
+    cache = last_level_cache_bytes();
+  }
+}
+
+// Sets ARRAY_SIZE for --arraysize auto[:FACTOR] or mem:PCT. With --processes, the arrays of all
+// the workers together are sized this way, and the plugin driver sizes them for the smallest
+// memory and largest cache of its implementations, so they all run the same size.
+void choose_array_size(size_t element_size)
+{
+  size_t memory = 0, cache = 0;
+  bool on_device = false;
+#if defined(PLUGIN_DRIVER)
+  for (size_t p = 0; p < plugins.size(); p++)
+  {
+    size_t plugin_memory, plugin_cache;
+    bool plugin_on_device;
+    array_memory(plugins[p]->device_memory, plugin_memory, plugin_cache, plugin_on_device);
+    memory = (p == 0) ? plugin_memory : std::min(memory, plugin_memory);
+    cache = std::max(cache, plugin_cache);
+    on_device = on_device || plugin_on_device;
+  }
+#else
+  array_memory(getDeviceMemory, memory, cache, on_device);
+#endif
+
+  if (memory == 0)
+  {
+    std::cerr << "The memory available for the arrays could not be found; "
+              << "give --arraysize as a number of elements" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (auto_size == AutoSize::Cache && cache == 0)
+  {
+    std::cerr << "The size of the last-level cache could not be found; "
+              << "give --arraysize as mem:PCT or a number of elements" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // Sizes are whole multiples of a power of two, which the device implementations need for
+  // their work-group sizes
+  const intptr_t granule = 1 << 16;
+  const double copies = 3.0 * (processes ? processes : 1);
+  const double most = (auto_size == AutoSize::Cache ? auto_memory_fraction : auto_size_factor / 100.0)
+                      * memory / (copies * element_size);
+  intptr_t n = static_cast<intptr_t>(most) / granule * granule;
+
+  std::ostringstream choice;
+  if (auto_size == AutoSize::Cache)
+  {
+    const double wanted = auto_size_factor * cache / ((processes ? processes : 1) * element_size);
+    if (wanted <= n)
+    {
+      n = static_cast<intptr_t>(std::ceil(wanted / granule)) * granule;
+      choice << auto_size_factor << " x " << std::fixed << std::setprecision(1)
+             << cache * 1.0E-6 << " MB last-level cache";
+    }
+    else
+    {
+      std::cerr << "Warning: arrays of " << auto_size_factor << " times the last-level cache do not fit in "
+                << auto_memory_fraction * 100 << "% of the available memory, so some kernels may run "
+                << "partly from cache" << std::endl;
+      choice << auto_memory_fraction * 100 << "% of " << std::fixed << std::setprecision(1)
+             << memory * 1.0E-6 << " MB available memory";
+    }
+  }
+  else
+  {
+    choice << auto_size_factor << "% of " << std::fixed << std::setprecision(1)
+           << memory * 1.0E-6 << " MB available memory";
+  }
+  choice << (on_device ? " of the device" : " of the host");
+
+  // The device implementations size their arrays with int
+  if (on_device)
+    n = std::min<intptr_t>(n, std::numeric_limits<int>::max() / granule * granule);
+
+  if (n < granule)
+  {
+    std::cerr << "Only " << memory << " bytes are available for the arrays, too few to size them "
+              << "automatically" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  ARRAY_SIZE = n;
+  array_size_choice = choice.str();
+}
+
 int parseInt(const char *str, int *output)
 {
   char *next;
@@ -588,14 +3327,104 @@ int parseInt(const char *str, int *output)
   return !strlen(next);
 }
 
+int parseSize(const char *str, intptr_t *output)
+{
+  char *next;
+  errno = 0;
+  long long value = strtoll(str, &next, 10);
+  if (errno == ERANGE || value > std::numeric_limits<intptr_t>::max())
+    return 0;
+  *output = value;
+  return !strlen(next);
+}
+
+int parseDouble(const char *str, double *output)
+{
+  char *next;
+  *output = strtod(str, &next);
+  return !strlen(next);
+}
+
+// Parses the argument of --arraysize: a number of elements, auto[:FACTOR] or mem:PCT
+int parseArraySize(const char *str)
+{
+  std::string spec(str);
+  if (spec == "auto")
+  {
+    auto_size = AutoSize::Cache;
+    auto_size_factor = 4.0;
+    return 1;
+  }
+  if (!spec.compare(0, 5, "auto:"))
+  {
+    auto_size = AutoSize::Cache;
+    return parseDouble(str + 5, &auto_size_factor) && auto_size_factor >= 1.0;
+  }
+  if (!spec.compare(0, 4, "mem:"))
+  {
+    auto_size = AutoSize::Memory;
+    return parseDouble(str + 4, &auto_size_factor) &&
+           auto_size_factor > 0.0 && auto_size_factor <= max_memory_percent;
+  }
+  auto_size = AutoSize::None;
+  return parseSize(str, &ARRAY_SIZE) && ARRAY_SIZE > 0;
+}
+
+// Parses MIN:MAX:FACTOR into a geometric sequence of array sizes, ending with MAX
+int parseSweep(const char *str, std::vector<intptr_t> *output)
+{
+  std::string spec(str);
+  size_t first = spec.find(':');
+  size_t second = (first == std::string::npos) ? first : spec.find(':', first + 1);
+  if (second == std::string::npos)
+    return 0;
+
+  intptr_t min, max;
+  double factor;
+  if (!parseSize(spec.substr(0, first).c_str(), &min) ||
+      !parseSize(spec.substr(first + 1, second - first - 1).c_str(), &max) ||
+      !parseDouble(spec.c_str() + second + 1, &factor) ||
+      min <= 0 || max < min || !(factor > 1.0))
+    return 0;
+
+  output->clear();
+  for (double size = min; size <= max; size *= factor)
+  {
+    // Skip sizes that truncate to the previous one when the factor is small
+    intptr_t n = static_cast<intptr_t>(size);
+    if (output->empty() || n > output->back())
+      output->push_back(n);
+  }
+  // The arrays are allocated for the last size, so MAX ends the sweep even when off the grid
+  if (output->back() < max)
+    output->push_back(max);
+  return 1;
+}
+
+// Parses MIN:MAX into a range of thread counts
+int parseScaling(const char *str, int *min, int *max)
+{
+  std::string spec(str);
+  size_t colon = spec.find(':');
+  if (colon == std::string::npos)
+    return 0;
+  return parseInt(spec.substr(0, colon).c_str(), min) &&
+         parseInt(spec.c_str() + colon + 1, max) &&
+         *min >= 1 && *max >= *min;
+}
+
 void parseArguments(int argc, char *argv[])
 {
   for (int i = 1; i < argc; i++)
   {
     if (!std::string("--list").compare(argv[i]))
     {
+#if defined(PLUGIN_DRIVER)
+      list_plugin_devices = true;
+#else
       listDevices();
       exit(EXIT_SUCCESS);
+#endif
     }
     else if (!std::string("--device").compare(argv[i]))
     {
@@ -608,9 +3437,18 @@ void parseArguments(int argc, char *argv[])
     else if (!std::string("--arraysize").compare(argv[i]) ||
              !std::string("-s").compare(argv[i]))
     {
-      if (++i >= argc || !parseInt(argv[i], &ARRAY_SIZE) || ARRAY_SIZE <= 0)
+      if (++i >= argc || !parseArraySize(argv[i]))
+      {
+        std::cerr << "Invalid array size, expected a number of elements, auto[:FACTOR] with FACTOR >= 1 "
+                  << "or mem:PCT with 0 < PCT <= " << max_memory_percent << "." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--sweep").compare(argv[i]))
+    {
+      if (++i >= argc || !parseSweep(argv[i], &sweep_sizes))
       {
-        std::cerr << "Invalid array size." << std::endl;
+        std::cerr << "Invalid array size sweep, expected MIN:MAX:FACTOR with FACTOR > 1." << std::endl;
         exit(EXIT_FAILURE);
       }
     }
@@ -640,6 +3478,318 @@ void parseArguments(int argc, char *argv[])
     {
       selection = Benchmark::Nstream;
     }
+    else if (!std::string("--latency").compare(argv[i]))
+    {
+      selection = Benchmark::Latency;
+    }
+    else if (!std::string("--loaded-latency").compare(argv[i]))
+    {
+      if (++i >= argc || (std::string("triad").compare(argv[i]) && std::string("copy").compare(argv[i])))
+      {
+        std::cerr << "Invalid kernel for --loaded-latency, expected triad or copy." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      selection = Benchmark::LoadedLatency;
+      loaded_kernel = argv[i];
+    }
+    else if (!std::string("--gather-scatter").compare(argv[i]))
+    {
+      if (++i >= argc)
+      {
+        std::cerr << "Missing index pattern for --gather-scatter." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      std::string pattern = argv[i];
+      selection = Benchmark::GatherScatter;
+      if (pattern == "identity")
+        index_config.pattern = IndexPattern::Identity;
+      else if (pattern == "random")
+        index_config.pattern = IndexPattern::Random;
+      else if (pattern.compare(0, 7, "stride:") == 0 || pattern.compare(0, 6, "block:") == 0)
+      {
+        bool stride = pattern[0] == 's';
+        index_config.pattern = stride ? IndexPattern::Stride : IndexPattern::Block;
+        if (!parseInt(pattern.c_str() + (stride ? 7 : 6), &index_config.parameter) || index_config.parameter < 1)
+        {
+          std::cerr << "Invalid element count in " << pattern << "." << std::endl;
+          exit(EXIT_FAILURE);
+        }
+      }
+      else
+      {
+        std::cerr << "Invalid index pattern " << pattern << "." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--stats").compare(argv[i]))
+    {
+      output_stats = true;
+    }
+    else if (!std::string("--until-stable").compare(argv[i]))
+    {
+      until_stable = true;
+      output_stats = true;
+    }
+    else if (!std::string("--ci-width").compare(argv[i]))
+    {
+      if (++i >= argc || !parseDouble(argv[i], &stable_ci_width) || stable_ci_width <= 0.0)
+      {
+        std::cerr << "Invalid confidence interval width." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      // Given as a percentage
+      stable_ci_width /= 100.0;
+    }
+    else if (!std::string("--time-budget").compare(argv[i]))
+    {
+      if (++i >= argc || !parseDouble(argv[i], &stable_time_budget) || stable_time_budget <= 0.0)
+      {
+        std::cerr << "Invalid time budget." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--json").compare(argv[i]))
+    {
+      if (++i >= argc)
+      {
+        std::cerr << "Missing file name for --json." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      json_file = argv[i];
+    }
+    else if (!std::string("--numa").compare(argv[i]))
+    {
+      if (++i >= argc)
+      {
+        std::cerr << "Missing policy for --numa." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      std::string policy = argv[i];
+      NumaConfig& config = numa_config();
+      if (policy == "local")
+        config.policy = NumaPolicy::Local;
+      else if (policy == "interleave")
+        config.policy = NumaPolicy::Interleave;
+      else if (policy == "split")
+        config.policy = NumaPolicy::Split;
+      else if (policy.compare(0, 5, "bind:") == 0)
+      {
+        std::vector<int> nodes = online_numa_nodes();
+        config.policy = NumaPolicy::Bind;
+        if (!parseInt(policy.c_str() + 5, &config.node)
+            || std::find(nodes.begin(), nodes.end(), config.node) == nodes.end())
+        {
+          std::cerr << "NUMA node in " << policy << " is not online." << std::endl;
+          exit(EXIT_FAILURE);
+        }
+      }
+      else
+      {
+        std::cerr << "Invalid NUMA policy " << policy << "." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--threads").compare(argv[i]))
+    {
+      if (++i >= argc || !parseInt(argv[i], &affinity_config().threads) || affinity_config().threads < 1)
+      {
+        std::cerr << "Invalid number of threads." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--scaling").compare(argv[i]))
+    {
+      if (++i >= argc || !parseScaling(argv[i], &scaling_min, &scaling_max))
+      {
+        std::cerr << "Invalid thread counts for --scaling, expected MIN:MAX." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--processes").compare(argv[i]))
+    {
+      if (++i >= argc || !parseInt(argv[i], &processes) || processes < 1)
+      {
+        std::cerr << "Invalid number of processes." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--bind").compare(argv[i]))
+    {
+      if (++i >= argc)
+      {
+        std::cerr << "Missing binding for --bind." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      affinity_config().bind = argv[i];
+    }
+    else if (!std::string("--pages").compare(argv[i]))
+    {
+      if (++i >= argc)
+      {
+        std::cerr << "Missing page type for --pages." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      std::string pages = argv[i];
+      PageBackend backends[] = {PageBackend::Default, PageBackend::Small, PageBackend::THP,
+                                PageBackend::Hugetlb2M, PageBackend::Hugetlb1G};
+      bool found = false;
+      for (PageBackend backend : backends)
+        if (pages == page_backend_name(backend))
+        {
+          page_config().backend = backend;
+          found = true;
+        }
+      if (!found)
+      {
+        std::cerr << "Invalid page type " << pages << "." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--prefault").compare(argv[i]))
+    {
+      page_config().prefault = true;
+    }
+    else if (!std::string("--nontemporal").compare(argv[i]))
+    {
+      nontemporal = true;
+    }
+    else if (!std::string("--cache-resident").compare(argv[i]))
+    {
+      if (++i >= argc || !parseInt(argv[i], &cache_resident_repeats) || cache_resident_repeats < 1)
+      {
+        std::cerr << "Invalid number of passes for --cache-resident." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--omp-schedule").compare(argv[i]))
+    {
+      if (++i >= argc)
+      {
+        std::cerr << "Missing schedule for --omp-schedule." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      // KIND or KIND,CHUNK
+      std::string schedule = argv[i];
+      std::string kind = schedule.substr(0, schedule.find(','));
+      use_schedule = true;
+      loop_schedule.chunk = 0;
+      if (kind == "static")
+        loop_schedule.kind = LoopSchedule::Static;
+      else if (kind == "dynamic")
+        loop_schedule.kind = LoopSchedule::Dynamic;
+      else if (kind == "guided")
+        loop_schedule.kind = LoopSchedule::Guided;
+      else if (kind == "taskloop")
+        loop_schedule.kind = LoopSchedule::Taskloop;
+      else
+      {
+        std::cerr << "Invalid schedule " << schedule << "." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      if (kind.size() < schedule.size() &&
+          (!parseInt(schedule.c_str() + kind.size() + 1, &loop_schedule.chunk) || loop_schedule.chunk < 1))
+      {
+        std::cerr << "Invalid chunk size in " << schedule << "." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--per-thread").compare(argv[i]))
+    {
+      per_thread = true;
+    }
+    else if (!std::string("--persistent").compare(argv[i]))
+    {
+      persistent = true;
+    }
+    else if (!std::string("--order").compare(argv[i]))
+    {
+      if (++i >= argc)
+      {
+        std::cerr << "Missing order for --order." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      std::string order = argv[i];
+      use_access_order = true;
+      if (order == "reverse")
+        access_order_kind = AccessOrder::Reverse;
+      else if (order.compare(0, 7, "stride:") == 0)
+      {
+        access_order_kind = AccessOrder::Strided;
+        if (!parseInt(order.c_str() + 7, &access_stride) || access_stride < 1)
+        {
+          std::cerr << "Invalid stride in " << order << "." << std::endl;
+          exit(EXIT_FAILURE);
+        }
+      }
+      else if (order.compare(0, 7, "blocks:") == 0)
+      {
+        // A block size in bytes, optionally in KiB or MiB
+        access_order_kind = AccessOrder::Blocks;
+        std::string size = order.substr(7);
+        intptr_t unit = 1;
+        if (!size.empty() && (size.back() == 'k' || size.back() == 'K'))
+          unit = 1024;
+        else if (!size.empty() && (size.back() == 'm' || size.back() == 'M'))
+          unit = 1024 * 1024;
+        if (unit > 1)
+          size.pop_back();
+        if (!parseSize(size.c_str(), &access_block_bytes) || access_block_bytes < 1 ||
+            access_block_bytes > std::numeric_limits<intptr_t>::max() / unit)
+        {
+          std::cerr << "Invalid block size in " << order << "." << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        access_block_bytes *= unit;
+      }
+      else
+      {
+        std::cerr << "Invalid order " << order << "." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--verify").compare(argv[i]) || !std::string(argv[i]).compare(0, 9, "--verify="))
+    {
+      // Also accepted as --verify=MODE
+      std::string mode;
+      if (argv[i][8] == '=')
+        mode = argv[i] + 9;
+      else if (++i < argc)
+        mode = argv[i];
+      if (mode == "full")
+        verify_mode = VerifyMode::Full;
+      else if (mode == "sample")
+        verify_mode = VerifyMode::Sample;
+      else if (mode == "none")
+        verify_mode = VerifyMode::None;
+      else
+      {
+        std::cerr << "Invalid mode for --verify, expected full, sample or none." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    else if (!std::string("--energy").compare(argv[i]))
+    {
+      use_energy = true;
+    }
+    else if (!std::string("--perf").compare(argv[i]))
+    {
+      use_perf = true;
+    }
+#if defined(PLUGIN_DRIVER)
+    else if (!std::string("--plugin").compare(argv[i]))
+    {
+      if (++i >= argc)
+      {
+        std::cerr << "Missing file name for --plugin." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      load_plugin(argv[i]);
+    }
+    else if (!std::string("--fork").compare(argv[i]))
+    {
+      fork_plugins = true;
+    }
+#endif
     else if (!std::string("--csv").compare(argv[i]))
     {
       output_as_csv = true;
@@ -658,11 +3808,58 @@ void parseArguments(int argc, char *argv[])
       std::cout << "      --list               List available devices" << std::endl;
       std::cout << "      --device     INDEX   Select device at INDEX" << std::endl;
       std::cout << "  -s  --arraysize  SIZE    Use SIZE elements in the array" << std::endl;
+      std::cout << "      --arraysize auto[:FACTOR]" << std::endl;
+      std::cout << "                           Make each array FACTOR (default 4) times the last-level cache, within half" << std::endl;
+      std::cout << "                           the available memory of the host or device" << std::endl;
+      std::cout << "      --arraysize mem:PCT  Make the three arrays PCT percent of the available memory" << std::endl;
+      std::cout << "      --sweep MIN:MAX:FACTOR" << std::endl;
+      std::cout << "                           Run each array size from MIN to MAX elements, growing by FACTOR" << std::endl;
       std::cout << "  -n  --numtimes   NUM     Run the test NUM times (NUM >= 2)" << std::endl;
       std::cout << "      --float              Use floats (rather than doubles)" << std::endl;
       std::cout << "      --triad-only         Only run triad" << std::endl;
       std::cout << "      --nstream-only       Only run nstream" << std::endl;
+      std::cout << "      --latency            Only measure load latency with a random pointer chase, over --sweep sizes" << std::endl;
+      std::cout << "                           or by default from 4 KiB up to the size of one array" << std::endl;
+      std::cout << "      --loaded-latency KERNEL" << std::endl;
+      std::cout << "                           Measure latency on a spare CPU while the workers run KERNEL (triad or copy)" << std::endl;
+      std::cout << "                           at decreasing intensity; leave a CPU free with --threads and --bind" << std::endl;
+      std::cout << "      --gather-scatter PATTERN" << std::endl;
+      std::cout << "                           Only run gather and scatter, with identity, stride:N, block:N or random indices" << std::endl;
+      std::cout << "      --stats              Also print median, standard deviation, percentiles and a 95% CI" << std::endl;
+      std::cout << "      --until-stable       Run at least NUM times, then until every median runtime is stable (implies --stats)" << std::endl;
+      std::cout << "      --ci-width   PCT     Stable once the 95% CI of the median is within PCT percent (default 1)" << std::endl;
+      std::cout << "      --time-budget SEC    Stop --until-stable after SEC seconds even if not stable (default 60)" << std::endl;
+      std::cout << "      --threads    NUM     Use NUM worker threads" << std::endl;
+      std::cout << "      --bind       BIND    Pin worker threads: compact, spread or a CPU list such as 0-3,8" << std::endl;
+      std::cout << "      --scaling    MIN:MAX Run at every thread count from MIN to MAX, pinned compactly unless" << std::endl;
+      std::cout << "                           --bind is given, and report the parallel efficiency" << std::endl;
+      std::cout << "      --processes  NUM     Fork NUM worker processes, each pinned to its share of the CPUs with" << std::endl;
+      std::cout << "                           arrays of its own, starting every kernel together; report node bandwidth" << std::endl;
+      std::cout << "      --numa       POLICY  Place host arrays: local, interleave, bind:NODE or split (one block per node)" << std::endl;
+      std::cout << "      --pages      TYPE    Back host arrays with default, 4k, thp, hugetlb-2m or hugetlb-1g pages" << std::endl;
+      std::cout << "      --prefault           Fault in host arrays at allocation, from the main thread" << std::endl;
+      std::cout << "      --nontemporal        Also time the kernels with non-temporal (streaming) stores" << std::endl;
+      std::cout << "      --cache-resident K   Repeat each kernel K times per timed call in one parallel region," << std::endl;
+      std::cout << "                           timed with the TSC, for arrays that fit in cache" << std::endl;
+      std::cout << "      --omp-schedule SCHED Loop schedule of the kernels: static, dynamic or guided, or taskloop" << std::endl;
+      std::cout << "                           for tasks, each optionally with a chunk size as in dynamic,64" << std::endl;
+      std::cout << "      --per-thread         Record what every worker thread does in each kernel call and report" << std::endl;
+      std::cout << "                           per-thread bandwidth and load imbalance" << std::endl;
+      std::cout << "      --persistent         Also run the kernels inside one parallel region, with barriers" << std::endl;
+      std::cout << "                           between them, and report the fork/join overhead" << std::endl;
+      std::cout << "      --order      ORDER   Also time Copy and Triad visiting the elements in another order:" << std::endl;
+      std::cout << "                           reverse, stride:N or blocks:SIZE (such as 4k or 2m) in random order" << std::endl;
+      std::cout << "      --perf               Also read hardware performance counters around each kernel" << std::endl;
+      std::cout << "      --energy             Also read the RAPL package and DRAM energy counters around each kernel, and" << std::endl;
+      std::cout << "                           report joules, watts and bandwidth per watt (default benchmark only)" << std::endl;
+      std::cout << "      --verify     MODE    Check the results: full (default), sample (about 2^20 elements" << std::endl;
+      std::cout << "                           of each array) or none" << std::endl;
+#if defined(PLUGIN_DRIVER)
+      std::cout << "      --plugin     FILE    Load the implementation built as plugin library FILE; repeat to compare several" << std::endl;
+      std::cout << "      --fork               Run each plugin in a child process of its own" << std::endl;
+#endif
       std::cout << "      --csv                Output as csv table" << std::endl;
+      std::cout << "      --json       FILE    Also write every timing and the run metadata to FILE as JSON" << std::endl;
       std::cout << "      --mibibytes          Use MiB=2^20 for bandwidth calculation (default MB=10^6)" << std::endl;
       std::cout << std::endl;
       exit(EXIT_SUCCESS);
@@ -0,0 +1,137 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+// The implementation selected at build time, shared by the driver and the plugin library
+
+#include "Stream.h"
+
+#include <iostream>
+#include <limits>
+#include <cstdlib>
+
+#if defined(CUDA)
+#include "CUDAStream.h"
+#elif defined(STD_DATA)
+#include "STDDataStream.h"
+#elif defined(STD_INDICES)
+#include "STDIndicesStream.h"
+#elif defined(STD_RANGES)
+#include "STDRangesStream.hpp"
+#elif defined(TBB)
+#include "TBBStream.hpp"
+#elif defined(THRUST)
+#include "ThrustStream.h"
+#elif defined(HIP)
+#include "HIPStream.h"
+#elif defined(HC)
+#include "HCStream.h"
+#elif defined(OCL)
+#include "OCLStream.h"
+#elif defined(USE_RAJA)
+#include "RAJAStream.hpp"
+#elif defined(KOKKOS)
+#include "KokkosStream.hpp"
+#elif defined(ACC)
+#include "ACCStream.h"
+#elif defined(SYCL)
+#include "SYCLStream.h"
+#elif defined(SYCL2020)
+#include "SYCLStream2020.h"
+#elif defined(OMP)
+#include "OMPStream.h"
+#elif defined(SIMD)
+#include "SIMDStream.h"
+#elif defined(FUTHARK)
+#include "FutharkStream.h"
+#endif
+
+// Construct the selected implementation with the given number of elements on the given device
+template <typename T>
+Stream<T> *make_model_stream(const intptr_t array_size, const unsigned int deviceIndex)
+{
+  Stream<T> *stream;
+
+#if !defined(OMP) && !defined(TBB) && !defined(SIMD) && \
+    !defined(STD_DATA) && !defined(STD_INDICES) && !defined(STD_RANGES)
+  // The other implementations still size and index their arrays with int
+  if (array_size > std::numeric_limits<int>::max())
+  {
+    std::cerr << "The " << IMPLEMENTATION_STRING << " implementation supports at most "
+              << std::numeric_limits<int>::max() << " elements per array" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+#endif
+
+#if defined(CUDA)
+  // Use the CUDA implementation
+  stream = new CUDAStream<T>(array_size, deviceIndex);
+
+#elif defined(HIP)
+  // Use the HIP implementation
+  stream = new HIPStream<T>(array_size, deviceIndex);
+
+#elif defined(HC)
+  // Use the HC implementation
+  stream = new HCStream<T>(array_size, deviceIndex);
+
+#elif defined(OCL)
+  // Use the OpenCL implementation
+  stream = new OCLStream<T>(array_size, deviceIndex);
+
+#elif defined(USE_RAJA)
+  // Use the RAJA implementation
+  stream = new RAJAStream<T>(array_size, deviceIndex);
+
+#elif defined(KOKKOS)
+  // Use the Kokkos implementation
+  stream = new KokkosStream<T>(array_size, deviceIndex);
+
+#elif defined(STD_DATA)
+  // Use the C++ STD data-oriented implementation
+  stream = new STDDataStream<T>(array_size, deviceIndex);
+
+#elif defined(STD_INDICES)
+  // Use the C++ STD index-oriented implementation
+  stream = new STDIndicesStream<T>(array_size, deviceIndex);
+
+#elif defined(STD_RANGES)
+  // Use the C++ STD ranges implementation
+  stream = new STDRangesStream<T>(array_size, deviceIndex);
+
+#elif defined(TBB)
+  // Use the C++20 implementation
+  stream = new TBBStream<T>(array_size, deviceIndex);
+
+#elif defined(THRUST)
+  // Use the Thrust implementation
+  stream = new ThrustStream<T>(array_size, deviceIndex); 
+
+#elif defined(ACC)
+  // Use the OpenACC implementation
+  stream = new ACCStream<T>(array_size, deviceIndex);
+
+#elif defined(SYCL) || defined(SYCL2020)
+  // Use the SYCL implementation
+  stream = new SYCLStream<T>(array_size, deviceIndex);
+
+#elif defined(OMP)
+  // Use the OpenMP implementation
+  stream = new OMPStream<T>(array_size, deviceIndex);
+
+#elif defined(SIMD)
+  // Use the explicit SIMD implementation
+  stream = new SIMDStream<T>(array_size, deviceIndex);
+
+#elif defined(FUTHARK)
+  // Use the Futhark implementation
+  stream = new FutharkStream<T>(array_size, deviceIndex);
+
+#endif
+
+  return stream;
+}
@@ -169,6 +169,7 @@ OCLStream<T>::OCLStream(const int ARRAY_SIZE, const int device_index)
   dot_kernel = new cl::KernelFunctor<cl::Buffer, cl::Buffer, cl::Buffer, cl::LocalSpaceArg, cl_int>(program, "stream_dot");
 
   array_size = ARRAY_SIZE;
+  alloc_size = ARRAY_SIZE;
 
   // Check buffers fit on the device
   cl_ulong totalmem = device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
@@ -201,6 +202,15 @@ OCLStream<T>::~OCLStream()
   devices.clear();
 }
 
+template <class T>
+bool OCLStream<T>::set_active_size(const intptr_t n)
+{
+  if (n > alloc_size)
+    return false;
+  array_size = n;
+  return true;
+}
+
 template <class T>
 void OCLStream<T>::copy()
 {
@@ -285,6 +295,15 @@ void OCLStream<T>::read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector
   cl::copy(queue, d_c, c.begin(), c.end());
 }
 
+template <class T>
+bool OCLStream<T>::read_range(const intptr_t begin, std::vector<T>& a, std::vector<T>& b, std::vector<T>& c)
+{
+  queue.enqueueReadBuffer(d_a, CL_TRUE, begin * sizeof(T), a.size() * sizeof(T), a.data());
+  queue.enqueueReadBuffer(d_b, CL_TRUE, begin * sizeof(T), b.size() * sizeof(T), b.data());
+  queue.enqueueReadBuffer(d_c, CL_TRUE, begin * sizeof(T), c.size() * sizeof(T), c.data());
+  return true;
+}
+
 void getDeviceList(void)
 {
   // Get list of platforms
@@ -364,6 +383,24 @@ std::string getDeviceDriver(const int device)
   return driver;
 }
 
+bool getDeviceMemory(const int device, size_t& memory, size_t& cache)
+{
+  if (!cached)
+    getDeviceList();
+
+  if (device < devices.size())
+  {
+    memory = devices[device].getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
+    cache = devices[device].getInfo<CL_DEVICE_GLOBAL_MEM_CACHE_SIZE>();
+  }
+  else
+  {
+    throw std::runtime_error("Error asking for memory of non-existant device");
+  }
+
+  return true;
+}
+
 
 template class OCLStream<float>;
 template class OCLStream<double>;
@@ -5,22 +5,240 @@
 // For full license terms please see the LICENSE file distributed with this
 // source code
 
-#include <cstdlib>  // For aligned_alloc
 #include "OMPStream.h"
+#include "host_alloc.h"
+#include "tsc.h"
 
-#ifndef ALIGNMENT
-#define ALIGNMENT (2*1024*1024) // 2MB
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+// Non-temporal stores are written explicitly with SSE2/AVX/AVX-512 intrinsics on x86,
+// as GCC and Clang do not generate them for these loops on their own.
+// Elsewhere the OpenMP 5.0 nontemporal clause is the best we can do.
+#if !defined(OMP_TARGET_GPU)
+#if defined(__SSE2__)
+#define OMP_NT_INTRINSICS
+#include <immintrin.h>
+#include <cstdint>
+#elif _OPENMP >= 201811
+#define OMP_NT_CLAUSE
+#endif
+#endif
+
+#ifdef OMP_NT_INTRINSICS
+// The widest vectors the build targets
+template <class T> struct NTVector;
+
+template <> struct NTVector<double>
+{
+#if defined(__AVX512F__)
+  typedef __m512d type;
+  static type load(const double *p) { return _mm512_loadu_pd(p); }
+  static type set1(double x) { return _mm512_set1_pd(x); }
+  static type add(type x, type y) { return _mm512_add_pd(x, y); }
+  static type mul(type x, type y) { return _mm512_mul_pd(x, y); }
+  static void stream(double *p, type x) { _mm512_stream_pd(p, x); }
+#elif defined(__AVX__)
+  typedef __m256d type;
+  static type load(const double *p) { return _mm256_loadu_pd(p); }
+  static type set1(double x) { return _mm256_set1_pd(x); }
+  static type add(type x, type y) { return _mm256_add_pd(x, y); }
+  static type mul(type x, type y) { return _mm256_mul_pd(x, y); }
+  static void stream(double *p, type x) { _mm256_stream_pd(p, x); }
+#else
+  typedef __m128d type;
+  static type load(const double *p) { return _mm_loadu_pd(p); }
+  static type set1(double x) { return _mm_set1_pd(x); }
+  static type add(type x, type y) { return _mm_add_pd(x, y); }
+  static type mul(type x, type y) { return _mm_mul_pd(x, y); }
+  static void stream(double *p, type x) { _mm_stream_pd(p, x); }
+#endif
+};
+
+template <> struct NTVector<float>
+{
+#if defined(__AVX512F__)
+  typedef __m512 type;
+  static type load(const float *p) { return _mm512_loadu_ps(p); }
+  static type set1(float x) { return _mm512_set1_ps(x); }
+  static type add(type x, type y) { return _mm512_add_ps(x, y); }
+  static type mul(type x, type y) { return _mm512_mul_ps(x, y); }
+  static void stream(float *p, type x) { _mm512_stream_ps(p, x); }
+#elif defined(__AVX__)
+  typedef __m256 type;
+  static type load(const float *p) { return _mm256_loadu_ps(p); }
+  static type set1(float x) { return _mm256_set1_ps(x); }
+  static type add(type x, type y) { return _mm256_add_ps(x, y); }
+  static type mul(type x, type y) { return _mm256_mul_ps(x, y); }
+  static void stream(float *p, type x) { _mm256_stream_ps(p, x); }
+#else
+  typedef __m128 type;
+  static type load(const float *p) { return _mm_loadu_ps(p); }
+  static type set1(float x) { return _mm_set1_ps(x); }
+  static type add(type x, type y) { return _mm_add_ps(x, y); }
+  static type mul(type x, type y) { return _mm_mul_ps(x, y); }
+  static void stream(float *p, type x) { _mm_stream_ps(p, x); }
+#endif
+};
+
+// Called by every thread of a parallel region: writes out[i] = element(i) over the thread's
+// static block of [0, n), using streaming stores of vector(i), the next vector of results,
+// wherever out is aligned to the vector size.
+template <class T, class E, class V>
+void stream_block(T *out, intptr_t n, E element, V vector)
+{
+  typedef NTVector<T> NT;
+  const int width = sizeof(typename NT::type) / sizeof(T);
+  const int threads = omp_get_num_threads();
+  const int thread = omp_get_thread_num();
+  intptr_t i = n * thread / threads;
+  const intptr_t end = n * (thread + 1) / threads;
+
+  for (; i < end && reinterpret_cast<uintptr_t>(out + i) % sizeof(typename NT::type); i++)
+    out[i] = element(i);
+  for (; i + width <= end; i += width)
+    NT::stream(out + i, vector(i));
+  for (; i < end; i++)
+    out[i] = element(i);
+
+  // Streaming stores are weakly ordered; make them visible before the region's barrier
+  _mm_sfence();
+}
+#endif
+
+#if !defined(OMP_TARGET_GPU)
+// The part [begin, end) of [0, n) that schedule(static) gives the given thread of a team,
+// which holds the elements it first touched in init_arrays
+inline void static_part(intptr_t n, int thread, int threads, intptr_t& begin, intptr_t& end)
+{
+  begin = thread * (n / threads) + std::min<intptr_t>(thread, n % threads);
+  end = begin + n / threads + (thread < n % threads ? 1 : 0);
+}
+
+// The same for the calling thread of a parallel region
+inline void static_part(intptr_t n, intptr_t& begin, intptr_t& end)
+{
+  static_part(n, omp_get_thread_num(), omp_get_num_threads(), begin, end);
+}
+
+// Called by every thread of a parallel region: calls f(i) for each element of the thread's static
+// part of [0, n) in the given order. Only the order within each part changes, so the threads
+// still work on the pages they first touched and the comparison with the forward kernels is not
+// mixed up with NUMA distance. The shuffled blocks, already cut at the edges of the parts, come
+// from thread_blocks.
+template <class F>
+void for_each_ordered(intptr_t n, const AccessOrder& order,
+                      const std::vector<std::vector<std::pair<intptr_t, intptr_t>>>& thread_blocks, F f)
+{
+  intptr_t begin, end;
+  static_part(n, begin, end);
+  switch (order.kind)
+  {
+    case AccessOrder::Reverse:
+      for (intptr_t i = end - 1; i >= begin; i--)
+        f(i);
+      break;
+    case AccessOrder::Strided:
+      for (int start = 0; start < order.stride; start++)
+        for (intptr_t i = begin + start; i < end; i += order.stride)
+          f(i);
+      break;
+    case AccessOrder::Blocks:
+      for (const std::pair<intptr_t, intptr_t>& block : thread_blocks[omp_get_thread_num()])
+        for (intptr_t i = block.first; i < block.second; i++)
+          f(i);
+      break;
+  }
+}
+
+// Calls f(begin, end) the given number of times on every thread of one parallel region, with a
+// barrier after each, where [begin, end) is the thread's part of [0, n). The parts are those
+// schedule(static) gives out, so each thread works on the elements it first touched in
+// init_arrays. Returns the ticks from when all threads have started to when all have finished.
+template <class F>
+uint64_t repeat_parts(intptr_t n, int repeats, F f)
+{
+  uint64_t start = 0, end = 0;
+  #pragma omp parallel
+  {
+    intptr_t part_begin, part_end;
+    static_part(n, part_begin, part_end);
+
+    #pragma omp barrier
+    #pragma omp single
+    start = timer_ticks();
+    for (int r = 0; r < repeats; r++)
+    {
+      f(part_begin, part_end);
+      #pragma omp barrier
+    }
+    #pragma omp master
+    end = timer_ticks();
+  }
+  return end - start;
+}
+
+// Called by every thread of a parallel region: calls f(i) for the elements of [0, n) the runtime
+// schedule gives the thread, and records when it started and finished and how many there were
+template <class F>
+void for_each_timed(intptr_t n, std::vector<ThreadTiming>& times, F f)
+{
+  const uint64_t start = timer_ticks();
+  size_t elements = 0;
+  #pragma omp for schedule(runtime) nowait
+  for (intptr_t i = 0; i < n; i++)
+  {
+    f(i);
+    elements++;
+  }
+  times[omp_get_thread_num()] = {start, timer_ticks(), elements};
+}
+
+// Calls f(begin, end) for consecutive chunks of [0, n) of the given size, or about four per
+// thread if 0, each as a task of one taskloop that a single thread of a parallel region creates
+template <class F>
+void taskloop_chunks(intptr_t n, intptr_t chunk, F f)
+{
+  if (chunk == 0)
+    chunk = std::max<intptr_t>(1, n / (4 * omp_get_max_threads()));
+  const intptr_t chunks = (n + chunk - 1) / chunk;
+  #pragma omp parallel
+  #pragma omp single
+  #pragma omp taskloop grainsize(1)
+  for (intptr_t k = 0; k < chunks; k++)
+    f(k * chunk, std::min(n, (k + 1) * chunk));
+}
 #endif
 
 template <class T>
-OMPStream<T>::OMPStream(const int ARRAY_SIZE, int device)
+OMPStream<T>::OMPStream(const intptr_t ARRAY_SIZE, int device)
 {
   array_size = ARRAY_SIZE;
+  alloc_size = ARRAY_SIZE;
+  nontemporal = false;
+  indices = nullptr;
+  order = nullptr;
+#ifndef OMP_TARGET_GPU
+  blocks_order = nullptr;
+  blocks_size = 0;
+#endif
+  repeats = 0;
+  ticks = 0;
+  taskloop = false;
+  taskloop_chunk = 0;
+  instrumented = false;
+
+#ifndef OMP_TARGET_GPU
+  // The kernels use schedule(runtime); static without a chunk size is the default schedule,
+  // which shares out the elements as the first touch in init_arrays did
+  omp_set_schedule(omp_sched_static, 0);
+#endif
 
-  // Allocate on the host
-  this->a = (T*)aligned_alloc(ALIGNMENT, sizeof(T)*array_size);
-  this->b = (T*)aligned_alloc(ALIGNMENT, sizeof(T)*array_size);
-  this->c = (T*)aligned_alloc(ALIGNMENT, sizeof(T)*array_size);
+  // Allocate on the host, placed according to the NUMA policy
+  this->a = host_alloc<T>(array_size);
+  this->b = host_alloc<T>(array_size);
+  this->c = host_alloc<T>(array_size);
 
 #ifdef OMP_TARGET_GPU
   omp_set_default_device(device);
@@ -39,22 +257,24 @@ OMPStream<T>::~OMPStream()
 {
 #ifdef OMP_TARGET_GPU
   // End data region on device
-  int array_size = this->array_size;
+  intptr_t alloc_size = this->alloc_size;
   T *a = this->a;
   T *b = this->b;
   T *c = this->c;
-  #pragma omp target exit data map(release: a[0:array_size], b[0:array_size], c[0:array_size])
+  #pragma omp target exit data map(release: a[0:alloc_size], b[0:alloc_size], c[0:alloc_size])
   {}
 #endif
-  free(a);
-  free(b);
-  free(c);
+  host_free(a);
+  host_free(b);
+  host_free(c);
+  if (indices)
+    host_free(indices);
 }
 
 template <class T>
 void OMPStream<T>::init_arrays(T initA, T initB, T initC)
 {
-  int array_size = this->array_size;
+  intptr_t array_size = this->array_size;
 #ifdef OMP_TARGET_GPU
   T *a = this->a;
   T *b = this->b;
@@ -63,7 +283,7 @@ void OMPStream<T>::init_arrays(T initA, T initB, T initC)
 #else
   #pragma omp parallel for
 #endif
-  for (int i = 0; i < array_size; i++)
+  for (intptr_t i = 0; i < array_size; i++)
   {
     a[i] = initA;
     b[i] = initB;
@@ -89,7 +309,7 @@ void OMPStream<T>::read_arrays(std::vector<T>& h_a, std::vector<T>& h_b, std::ve
 #endif
 
   #pragma omp parallel for
-  for (int i = 0; i < array_size; i++)
+  for (intptr_t i = 0; i < array_size; i++)
   {
     h_a[i] = a[i];
     h_b[i] = b[i];
@@ -98,18 +318,273 @@ void OMPStream<T>::read_arrays(std::vector<T>& h_a, std::vector<T>& h_b, std::ve
 
 }
 
+template <class T>
+bool OMPStream<T>::set_active_size(const intptr_t n)
+{
+  if (n > alloc_size)
+    return false;
+  array_size = n;
+#ifndef OMP_TARGET_GPU
+  if (order)
+    split_blocks();
+#endif
+  return true;
+}
+
+template <class T>
+bool OMPStream<T>::set_nontemporal(const bool enable)
+{
+#if defined(OMP_NT_INTRINSICS) || defined(OMP_NT_CLAUSE)
+  nontemporal = enable;
+  return true;
+#else
+  return false;
+#endif
+}
+
+template <class T>
+bool OMPStream<T>::set_access_order(const AccessOrder *order)
+{
+#ifdef OMP_TARGET_GPU
+  return false;
+#else
+  this->order = order;
+  if (order)
+    split_blocks();
+  return true;
+#endif
+}
+
+template <class T>
+bool OMPStream<T>::set_schedule(const LoopSchedule& schedule)
+{
+#ifdef OMP_TARGET_GPU
+  return false;
+#else
+  taskloop = false;
+  switch (schedule.kind)
+  {
+    case LoopSchedule::Static:
+      omp_set_schedule(omp_sched_static, schedule.chunk);
+      break;
+    case LoopSchedule::Dynamic:
+      omp_set_schedule(omp_sched_dynamic, schedule.chunk);
+      break;
+    case LoopSchedule::Guided:
+      omp_set_schedule(omp_sched_guided, schedule.chunk);
+      break;
+    case LoopSchedule::Taskloop:
+      taskloop = true;
+      taskloop_chunk = schedule.chunk;
+      break;
+  }
+  return true;
+#endif
+}
+
+template <class T>
+bool OMPStream<T>::set_instrumented(const bool enable)
+{
+#ifdef OMP_TARGET_GPU
+  return false;
+#else
+  instrumented = enable;
+  return true;
+#endif
+}
+
+template <class T>
+std::vector<ThreadTiming> OMPStream<T>::thread_timings()
+{
+  return thread_times;
+}
+
+template <class T>
+bool OMPStream<T>::set_repeats(const int repeats)
+{
+#ifdef OMP_TARGET_GPU
+  return false;
+#else
+  this->repeats = repeats;
+  return true;
+#endif
+}
+
+template <class T>
+uint64_t OMPStream<T>::repeat_ticks()
+{
+  return ticks;
+}
+
+template <class T>
+bool OMPStream<T>::run_persistent(const unsigned int iterations, std::vector<std::vector<double>>& timings, T& sum)
+{
+#ifdef OMP_TARGET_GPU
+  return false;
+#else
+  const int kernels = 5;
+  const intptr_t array_size = this->array_size;
+  const T scalar = startScalar;
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+
+  // Every thread stamps the start and end of its share of every call; the time stamp counter is
+  // synchronised across cores, so the stamps of different threads can be compared
+  const int threads = omp_get_max_threads();
+  std::vector<uint64_t> starts(static_cast<size_t>(iterations) * kernels * threads);
+  std::vector<uint64_t> ends(starts.size());
+  T result{};
+
+  #pragma omp parallel
+  {
+    const int thread = omp_get_thread_num();
+    for (unsigned int k = 0; k < iterations; k++)
+    {
+      uint64_t *start = &starts[(static_cast<size_t>(k) * kernels) * threads + thread];
+      uint64_t *end = &ends[(static_cast<size_t>(k) * kernels) * threads + thread];
+
+      #pragma omp barrier
+      start[0] = timer_ticks();
+      #pragma omp for schedule(static) nowait
+      for (intptr_t i = 0; i < array_size; i++)
+        c[i] = a[i];
+      end[0] = timer_ticks();
+
+      #pragma omp barrier
+      start[threads] = timer_ticks();
+      #pragma omp for schedule(static) nowait
+      for (intptr_t i = 0; i < array_size; i++)
+        b[i] = scalar * c[i];
+      end[threads] = timer_ticks();
+
+      #pragma omp barrier
+      start[2 * threads] = timer_ticks();
+      #pragma omp for schedule(static) nowait
+      for (intptr_t i = 0; i < array_size; i++)
+        c[i] = a[i] + b[i];
+      end[2 * threads] = timer_ticks();
+
+      #pragma omp barrier
+      start[3 * threads] = timer_ticks();
+      #pragma omp for schedule(static) nowait
+      for (intptr_t i = 0; i < array_size; i++)
+        a[i] = b[i] + scalar * c[i];
+      end[3 * threads] = timer_ticks();
+
+      // The reduction into result is complete at the next barrier, after which it is reset
+      #pragma omp master
+      result = T{};
+      #pragma omp barrier
+      start[4 * threads] = timer_ticks();
+      #pragma omp for schedule(static) reduction(+:result) nowait
+      for (intptr_t i = 0; i < array_size; i++)
+        result += a[i] * b[i];
+      end[4 * threads] = timer_ticks();
+    }
+  }
+
+  // Threads that did not take part in the region left their stamps at zero
+  for (unsigned int k = 0; k < iterations; k++)
+  {
+    for (int kernel = 0; kernel < kernels; kernel++)
+    {
+      const size_t first = (static_cast<size_t>(k) * kernels + kernel) * threads;
+      uint64_t start = UINT64_MAX, end = 0;
+      for (int t = 0; t < threads; t++)
+      {
+        if (ends[first + t] == 0)
+          continue;
+        start = std::min(start, starts[first + t]);
+        end = std::max(end, ends[first + t]);
+      }
+      timings[kernel].push_back(timer_seconds(end - start));
+    }
+  }
+  sum = result;
+  return true;
+#endif
+}
+
+template <class T>
+bool OMPStream<T>::set_indices(const std::vector<int>& h_indices)
+{
+#ifdef OMP_TARGET_GPU
+  return false;
+#else
+  if (h_indices.size() > static_cast<size_t>(alloc_size))
+    return false;
+  if (!indices)
+    indices = host_alloc<int>(alloc_size);
+
+  // Copied by the threads that will use them, like init_arrays
+  const intptr_t n = h_indices.size();
+  #pragma omp parallel for
+  for (intptr_t i = 0; i < n; i++)
+  {
+    indices[i] = h_indices[i];
+  }
+  return true;
+#endif
+}
+
+template <class T>
+void OMPStream<T>::gather()
+{
+#ifndef OMP_TARGET_GPU
+  if (taskloop)
+    return gather_taskloop();
+#endif
+
+  #pragma omp parallel for schedule(runtime)
+  for (intptr_t i = 0; i < array_size; i++)
+  {
+    a[i] = b[indices[i]];
+  }
+}
+
+template <class T>
+void OMPStream<T>::scatter()
+{
+#ifndef OMP_TARGET_GPU
+  if (taskloop)
+    return scatter_taskloop();
+#endif
+
+  #pragma omp parallel for schedule(runtime)
+  for (intptr_t i = 0; i < array_size; i++)
+  {
+    a[indices[i]] = b[i];
+  }
+}
+
 template <class T>
 void OMPStream<T>::copy()
 {
+#ifndef OMP_TARGET_GPU
+  if (repeats)
+    return copy_repeated();
+  if (order)
+    return copy_ordered();
+#endif
+  if (nontemporal)
+    return copy_nt();
+#ifndef OMP_TARGET_GPU
+  if (instrumented)
+    return copy_instrumented();
+  if (taskloop)
+    return copy_taskloop();
+#endif
+
 #ifdef OMP_TARGET_GPU
-  int array_size = this->array_size;
+  intptr_t array_size = this->array_size;
   T *a = this->a;
   T *c = this->c;
   #pragma omp target teams distribute parallel for simd
 #else
-  #pragma omp parallel for
+  #pragma omp parallel for schedule(runtime)
 #endif
-  for (int i = 0; i < array_size; i++)
+  for (intptr_t i = 0; i < array_size; i++)
   {
     c[i] = a[i];
   }
@@ -123,17 +598,30 @@ void OMPStream<T>::copy()
 template <class T>
 void OMPStream<T>::mul()
 {
+#ifndef OMP_TARGET_GPU
+  if (repeats)
+    return mul_repeated();
+#endif
+  if (nontemporal)
+    return mul_nt();
+#ifndef OMP_TARGET_GPU
+  if (instrumented)
+    return mul_instrumented();
+  if (taskloop)
+    return mul_taskloop();
+#endif
+
   const T scalar = startScalar;
 
 #ifdef OMP_TARGET_GPU
-  int array_size = this->array_size;
+  intptr_t array_size = this->array_size;
   T *b = this->b;
   T *c = this->c;
   #pragma omp target teams distribute parallel for simd
 #else
-  #pragma omp parallel for
+  #pragma omp parallel for schedule(runtime)
 #endif
-  for (int i = 0; i < array_size; i++)
+  for (intptr_t i = 0; i < array_size; i++)
   {
     b[i] = scalar * c[i];
   }
@@ -147,16 +635,29 @@ void OMPStream<T>::mul()
 template <class T>
 void OMPStream<T>::add()
 {
+#ifndef OMP_TARGET_GPU
+  if (repeats)
+    return add_repeated();
+#endif
+  if (nontemporal)
+    return add_nt();
+#ifndef OMP_TARGET_GPU
+  if (instrumented)
+    return add_instrumented();
+  if (taskloop)
+    return add_taskloop();
+#endif
+
 #ifdef OMP_TARGET_GPU
-  int array_size = this->array_size;
+  intptr_t array_size = this->array_size;
   T *a = this->a;
   T *b = this->b;
   T *c = this->c;
   #pragma omp target teams distribute parallel for simd
 #else
-  #pragma omp parallel for
+  #pragma omp parallel for schedule(runtime)
 #endif
-  for (int i = 0; i < array_size; i++)
+  for (intptr_t i = 0; i < array_size; i++)
   {
     c[i] = a[i] + b[i];
   }
@@ -170,18 +671,33 @@ void OMPStream<T>::add()
 template <class T>
 void OMPStream<T>::triad()
 {
+#ifndef OMP_TARGET_GPU
+  if (repeats)
+    return triad_repeated();
+  if (order)
+    return triad_ordered();
+#endif
+  if (nontemporal)
+    return triad_nt();
+#ifndef OMP_TARGET_GPU
+  if (instrumented)
+    return triad_instrumented();
+  if (taskloop)
+    return triad_taskloop();
+#endif
+
   const T scalar = startScalar;
 
 #ifdef OMP_TARGET_GPU
-  int array_size = this->array_size;
+  intptr_t array_size = this->array_size;
   T *a = this->a;
   T *b = this->b;
   T *c = this->c;
   #pragma omp target teams distribute parallel for simd
 #else
-  #pragma omp parallel for
+  #pragma omp parallel for schedule(runtime)
 #endif
-  for (int i = 0; i < array_size; i++)
+  for (intptr_t i = 0; i < array_size; i++)
   {
     a[i] = b[i] + scalar * c[i];
   }
@@ -195,18 +711,25 @@ void OMPStream<T>::triad()
 template <class T>
 void OMPStream<T>::nstream()
 {
+  if (nontemporal)
+    return nstream_nt();
+#ifndef OMP_TARGET_GPU
+  if (taskloop)
+    return nstream_taskloop();
+#endif
+
   const T scalar = startScalar;
 
 #ifdef OMP_TARGET_GPU
-  int array_size = this->array_size;
+  intptr_t array_size = this->array_size;
   T *a = this->a;
   T *b = this->b;
   T *c = this->c;
   #pragma omp target teams distribute parallel for simd
 #else
-  #pragma omp parallel for
+  #pragma omp parallel for schedule(runtime)
 #endif
-  for (int i = 0; i < array_size; i++)
+  for (intptr_t i = 0; i < array_size; i++)
   {
     a[i] += b[i] + scalar * c[i];
   }
@@ -220,17 +743,26 @@ void OMPStream<T>::nstream()
 template <class T>
 T OMPStream<T>::dot()
 {
+#ifndef OMP_TARGET_GPU
+  if (repeats)
+    return dot_repeated();
+  if (instrumented)
+    return dot_instrumented();
+  if (taskloop)
+    return dot_taskloop();
+#endif
+
   T sum{};
 
 #ifdef OMP_TARGET_GPU
-  int array_size = this->array_size;
+  intptr_t array_size = this->array_size;
   T *a = this->a;
   T *b = this->b;
   #pragma omp target teams distribute parallel for simd map(tofrom: sum) reduction(+:sum)
 #else
-  #pragma omp parallel for reduction(+:sum)
+  #pragma omp parallel for schedule(runtime) reduction(+:sum)
 #endif
-  for (int i = 0; i < array_size; i++)
+  for (intptr_t i = 0; i < array_size; i++)
   {
     sum += a[i] * b[i];
   }
@@ -240,6 +772,478 @@ T OMPStream<T>::dot()
 
 
 
+#if defined(OMP_NT_INTRINSICS)
+template <class T>
+void OMPStream<T>::copy_nt()
+{
+  T *a = this->a;
+  typedef NTVector<T> NT;
+  #pragma omp parallel
+  stream_block(c, array_size,
+    [=](intptr_t i) { return a[i]; },
+    [=](intptr_t i) { return NT::load(a + i); });
+}
+
+template <class T>
+void OMPStream<T>::mul_nt()
+{
+  const T scalar = startScalar;
+  T *c = this->c;
+  typedef NTVector<T> NT;
+  #pragma omp parallel
+  stream_block(b, array_size,
+    [=](intptr_t i) { return scalar * c[i]; },
+    [=](intptr_t i) { return NT::mul(NT::set1(scalar), NT::load(c + i)); });
+}
+
+template <class T>
+void OMPStream<T>::add_nt()
+{
+  T *a = this->a;
+  T *b = this->b;
+  typedef NTVector<T> NT;
+  #pragma omp parallel
+  stream_block(c, array_size,
+    [=](intptr_t i) { return a[i] + b[i]; },
+    [=](intptr_t i) { return NT::add(NT::load(a + i), NT::load(b + i)); });
+}
+
+template <class T>
+void OMPStream<T>::triad_nt()
+{
+  const T scalar = startScalar;
+  T *b = this->b;
+  T *c = this->c;
+  typedef NTVector<T> NT;
+  #pragma omp parallel
+  stream_block(a, array_size,
+    [=](intptr_t i) { return b[i] + scalar * c[i]; },
+    [=](intptr_t i) { return NT::add(NT::load(b + i), NT::mul(NT::set1(scalar), NT::load(c + i))); });
+}
+
+template <class T>
+void OMPStream<T>::nstream_nt()
+{
+  const T scalar = startScalar;
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  typedef NTVector<T> NT;
+  #pragma omp parallel
+  stream_block(a, array_size,
+    [=](intptr_t i) { return a[i] + b[i] + scalar * c[i]; },
+    [=](intptr_t i) { return NT::add(NT::load(a + i), NT::add(NT::load(b + i), NT::mul(NT::set1(scalar), NT::load(c + i)))); });
+}
+#else
+// With the OpenMP 5.0 nontemporal clause, or never called if neither is available.
+// The clause only takes variables, so the arrays are copied into locals.
+template <class T>
+void OMPStream<T>::copy_nt()
+{
+  T *a = this->a;
+  T *c = this->c;
+#ifdef OMP_NT_CLAUSE
+  #pragma omp parallel for simd nontemporal(c)
+#endif
+  for (intptr_t i = 0; i < array_size; i++)
+    c[i] = a[i];
+}
+
+template <class T>
+void OMPStream<T>::mul_nt()
+{
+  const T scalar = startScalar;
+  T *b = this->b;
+  T *c = this->c;
+#ifdef OMP_NT_CLAUSE
+  #pragma omp parallel for simd nontemporal(b)
+#endif
+  for (intptr_t i = 0; i < array_size; i++)
+    b[i] = scalar * c[i];
+}
+
+template <class T>
+void OMPStream<T>::add_nt()
+{
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+#ifdef OMP_NT_CLAUSE
+  #pragma omp parallel for simd nontemporal(c)
+#endif
+  for (intptr_t i = 0; i < array_size; i++)
+    c[i] = a[i] + b[i];
+}
+
+template <class T>
+void OMPStream<T>::triad_nt()
+{
+  const T scalar = startScalar;
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+#ifdef OMP_NT_CLAUSE
+  #pragma omp parallel for simd nontemporal(a)
+#endif
+  for (intptr_t i = 0; i < array_size; i++)
+    a[i] = b[i] + scalar * c[i];
+}
+
+template <class T>
+void OMPStream<T>::nstream_nt()
+{
+  const T scalar = startScalar;
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+#ifdef OMP_NT_CLAUSE
+  #pragma omp parallel for simd nontemporal(a)
+#endif
+  for (intptr_t i = 0; i < array_size; i++)
+    a[i] += b[i] + scalar * c[i];
+}
+#endif
+
+#if !defined(OMP_TARGET_GPU)
+// Cuts the blocks of a Blocks order at the edges of the threads' static parts, once for each order,
+// array size and thread count rather than in every kernel call
+template <class T>
+void OMPStream<T>::split_blocks()
+{
+  const int threads = omp_get_max_threads();
+  if (order->kind != AccessOrder::Blocks ||
+      (order == blocks_order && array_size == blocks_size && thread_blocks.size() == static_cast<size_t>(threads)))
+    return;
+
+  std::vector<intptr_t> starts(threads + 1);
+  for (int t = 0; t < threads; t++)
+    static_part(array_size, t, threads, starts[t], starts[t + 1]);
+
+  thread_blocks.assign(threads, std::vector<std::pair<intptr_t, intptr_t>>());
+  for (intptr_t block : order->blocks)
+  {
+    const intptr_t block_end = std::min(array_size, block + order->block_size);
+    // The first thread whose part holds the start of the block, then any it runs on into
+    int t = std::upper_bound(starts.begin(), starts.end() - 1, block) - starts.begin() - 1;
+    for (; t < threads && starts[t] < block_end; t++)
+    {
+      const intptr_t first = std::max(starts[t], block);
+      const intptr_t last = std::min(starts[t + 1], block_end);
+      if (first < last)
+        thread_blocks[t].push_back(std::make_pair(first, last));
+    }
+  }
+  blocks_order = order;
+  blocks_size = array_size;
+}
+
+template <class T>
+void OMPStream<T>::copy_ordered()
+{
+  T *a = this->a;
+  T *c = this->c;
+  #pragma omp parallel
+  for_each_ordered(array_size, *order, thread_blocks, [=](intptr_t i) { c[i] = a[i]; });
+}
+
+template <class T>
+void OMPStream<T>::triad_ordered()
+{
+  const T scalar = startScalar;
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  #pragma omp parallel
+  for_each_ordered(array_size, *order, thread_blocks, [=](intptr_t i) { a[i] = b[i] + scalar * c[i]; });
+}
+
+template <class T>
+void OMPStream<T>::copy_repeated()
+{
+  T *a = this->a;
+  T *c = this->c;
+  ticks = repeat_parts(array_size, repeats, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      c[i] = a[i];
+  });
+}
+
+template <class T>
+void OMPStream<T>::mul_repeated()
+{
+  const T scalar = startScalar;
+  T *b = this->b;
+  T *c = this->c;
+  ticks = repeat_parts(array_size, repeats, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      b[i] = scalar * c[i];
+  });
+}
+
+template <class T>
+void OMPStream<T>::add_repeated()
+{
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  ticks = repeat_parts(array_size, repeats, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      c[i] = a[i] + b[i];
+  });
+}
+
+template <class T>
+void OMPStream<T>::triad_repeated()
+{
+  const T scalar = startScalar;
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  ticks = repeat_parts(array_size, repeats, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      a[i] = b[i] + scalar * c[i];
+  });
+}
+
+template <class T>
+T OMPStream<T>::dot_repeated()
+{
+  // Each repetition overwrites the thread's partial sum, so the result is that of one pass
+  std::vector<T> partial(omp_get_max_threads());
+  T *sums = partial.data();
+  T *a = this->a;
+  T *b = this->b;
+  ticks = repeat_parts(array_size, repeats, [=](intptr_t begin, intptr_t end)
+  {
+    T sum{};
+    for (intptr_t i = begin; i < end; i++)
+      sum += a[i] * b[i];
+    sums[omp_get_thread_num()] = sum;
+  });
+  return std::accumulate(partial.begin(), partial.end(), T{});
+}
+
+template <class T>
+void OMPStream<T>::copy_taskloop()
+{
+  T *a = this->a;
+  T *c = this->c;
+  taskloop_chunks(array_size, taskloop_chunk, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      c[i] = a[i];
+  });
+}
+
+template <class T>
+void OMPStream<T>::mul_taskloop()
+{
+  const T scalar = startScalar;
+  T *b = this->b;
+  T *c = this->c;
+  taskloop_chunks(array_size, taskloop_chunk, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      b[i] = scalar * c[i];
+  });
+}
+
+template <class T>
+void OMPStream<T>::add_taskloop()
+{
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  taskloop_chunks(array_size, taskloop_chunk, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      c[i] = a[i] + b[i];
+  });
+}
+
+template <class T>
+void OMPStream<T>::triad_taskloop()
+{
+  const T scalar = startScalar;
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  taskloop_chunks(array_size, taskloop_chunk, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      a[i] = b[i] + scalar * c[i];
+  });
+}
+
+template <class T>
+void OMPStream<T>::nstream_taskloop()
+{
+  const T scalar = startScalar;
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  taskloop_chunks(array_size, taskloop_chunk, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      a[i] += b[i] + scalar * c[i];
+  });
+}
+
+template <class T>
+T OMPStream<T>::dot_taskloop()
+{
+  // Each task sums its chunk and adds it in atomically, which needs no task reductions (OpenMP 5.0)
+  T sum{};
+  T *total = &sum;
+  T *a = this->a;
+  T *b = this->b;
+  taskloop_chunks(array_size, taskloop_chunk, [=](intptr_t begin, intptr_t end)
+  {
+    T partial{};
+    for (intptr_t i = begin; i < end; i++)
+      partial += a[i] * b[i];
+    #pragma omp atomic
+    *total += partial;
+  });
+  return sum;
+}
+
+template <class T>
+void OMPStream<T>::gather_taskloop()
+{
+  T *a = this->a;
+  T *b = this->b;
+  int *indices = this->indices;
+  taskloop_chunks(array_size, taskloop_chunk, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      a[i] = b[indices[i]];
+  });
+}
+
+template <class T>
+void OMPStream<T>::scatter_taskloop()
+{
+  T *a = this->a;
+  T *b = this->b;
+  int *indices = this->indices;
+  taskloop_chunks(array_size, taskloop_chunk, [=](intptr_t begin, intptr_t end)
+  {
+    for (intptr_t i = begin; i < end; i++)
+      a[indices[i]] = b[i];
+  });
+}
+
+template <class T>
+void OMPStream<T>::copy_instrumented()
+{
+  T *a = this->a;
+  T *c = this->c;
+  thread_times.assign(omp_get_max_threads(), ThreadTiming());
+  std::vector<ThreadTiming>& times = thread_times;
+  #pragma omp parallel
+  for_each_timed(array_size, times, [=](intptr_t i) { c[i] = a[i]; });
+}
+
+template <class T>
+void OMPStream<T>::mul_instrumented()
+{
+  const T scalar = startScalar;
+  T *b = this->b;
+  T *c = this->c;
+  thread_times.assign(omp_get_max_threads(), ThreadTiming());
+  std::vector<ThreadTiming>& times = thread_times;
+  #pragma omp parallel
+  for_each_timed(array_size, times, [=](intptr_t i) { b[i] = scalar * c[i]; });
+}
+
+template <class T>
+void OMPStream<T>::add_instrumented()
+{
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  thread_times.assign(omp_get_max_threads(), ThreadTiming());
+  std::vector<ThreadTiming>& times = thread_times;
+  #pragma omp parallel
+  for_each_timed(array_size, times, [=](intptr_t i) { c[i] = a[i] + b[i]; });
+}
+
+template <class T>
+void OMPStream<T>::triad_instrumented()
+{
+  const T scalar = startScalar;
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  thread_times.assign(omp_get_max_threads(), ThreadTiming());
+  std::vector<ThreadTiming>& times = thread_times;
+  #pragma omp parallel
+  for_each_timed(array_size, times, [=](intptr_t i) { a[i] = b[i] + scalar * c[i]; });
+}
+
+template <class T>
+T OMPStream<T>::dot_instrumented()
+{
+  T sum{};
+  T *a = this->a;
+  T *b = this->b;
+  thread_times.assign(omp_get_max_threads(), ThreadTiming());
+  std::vector<ThreadTiming>& times = thread_times;
+  #pragma omp parallel reduction(+:sum)
+  for_each_timed(array_size, times, [&](intptr_t i) { sum += a[i] * b[i]; });
+  return sum;
+}
+#endif
+
+template <class T>
+bool OMPStream<T>::verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                          double& errA, double& errB, double& errC)
+{
+  double sumA = 0.0, sumB = 0.0, sumC = 0.0;
+
+  // On a device the arrays are checked there, without copying them back
+  intptr_t array_size = this->array_size;
+#ifdef OMP_TARGET_GPU
+  T *a = this->a;
+  T *b = this->b;
+  T *c = this->c;
+  #pragma omp target teams distribute parallel for simd map(tofrom: sumA, sumB, sumC) reduction(+:sumA, sumB, sumC)
+#else
+  #pragma omp parallel for reduction(+:sumA, sumB, sumC)
+#endif
+  for (intptr_t i = 0; i < array_size; i += stride)
+  {
+    sumA += std::fabs(a[i] - goldA);
+    sumB += std::fabs(b[i] - goldB);
+    sumC += std::fabs(c[i] - goldC);
+  }
+
+  const intptr_t n = (array_size + stride - 1) / stride;
+  errA = sumA / n;
+  errB = sumB / n;
+  errC = sumC / n;
+  return true;
+}
+
+template <class T>
+bool OMPStream<T>::host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c)
+{
+#ifdef OMP_TARGET_GPU
+  // The host copies are only up to date after read_arrays
+  return false;
+#else
+  a = {this->a, array_size};
+  b = {this->b, array_size};
+  c = {this->c, array_size};
+  return true;
+#endif
+}
+
 void listDevices(void)
 {
 #ifdef OMP_TARGET_GPU
@@ -269,5 +1273,16 @@ std::string getDeviceDriver(const int)
 {
   return std::string("Device driver unavailable");
 }
+
+bool getDeviceMemory(const int, size_t& memory, size_t& cache)
+{
+#if defined(OMP_TARGET_GPU)
+  // OpenMP has no query for the memory of a target device
+  memory = cache = 0;
+  return true;
+#else
+  return false;
+#endif
+}
 template class OMPStream<float>;
 template class OMPStream<double>;
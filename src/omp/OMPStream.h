@@ -9,6 +9,7 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <utility>
 
 #include "Stream.h"
 
@@ -20,16 +21,78 @@ template <class T>
 class OMPStream : public Stream<T>
 {
   protected:
-    // Size of arrays
-    int array_size;
+    // Size of arrays, and the number of elements actually allocated
+    intptr_t array_size;
+    intptr_t alloc_size;
 
     // Device side pointers
     T *a;
     T *b;
     T *c;
 
+    // Index array for gather and scatter, allocated by the first set_indices
+    int *indices;
+
+    // Order for copy and triad, or null to run them sequentially
+    const AccessOrder *order;
+#ifndef OMP_TARGET_GPU
+    // For a Blocks order, the [first, last) ranges of each thread in the order it visits them,
+    // and the order, array size and thread count they were made for
+    std::vector<std::vector<std::pair<intptr_t, intptr_t>>> thread_blocks;
+    const AccessOrder *blocks_order;
+    intptr_t blocks_size;
+    void split_blocks();
+    void copy_ordered();
+    void triad_ordered();
+#endif
+
+    // Number of repetitions per kernel call in cache-resident mode, or 0, and the ticks they took
+    int repeats;
+    uint64_t ticks;
+#ifndef OMP_TARGET_GPU
+    void copy_repeated();
+    void mul_repeated();
+    void add_repeated();
+    void triad_repeated();
+    T dot_repeated();
+#endif
+
+    // Record what each thread does in copy, mul, add, triad and dot
+    bool instrumented;
+    std::vector<ThreadTiming> thread_times;
+#ifndef OMP_TARGET_GPU
+    void copy_instrumented();
+    void mul_instrumented();
+    void add_instrumented();
+    void triad_instrumented();
+    T dot_instrumented();
+#endif
+
+    // Run the kernels as taskloops over chunks of taskloop_chunk elements (0 for about four per
+    // thread) rather than as loops with the runtime schedule
+    bool taskloop;
+    int taskloop_chunk;
+#ifndef OMP_TARGET_GPU
+    void copy_taskloop();
+    void mul_taskloop();
+    void add_taskloop();
+    void triad_taskloop();
+    void nstream_taskloop();
+    T dot_taskloop();
+    void gather_taskloop();
+    void scatter_taskloop();
+#endif
+
+    // Use the non-temporal variants of the kernels
+    bool nontemporal;
+    void copy_nt();
+    void mul_nt();
+    void add_nt();
+    void triad_nt();
+    void nstream_nt();
+
   public:
-    OMPStream(const int, int);
+    OMPStream(const intptr_t, int);
     ~OMPStream();
 
     virtual void copy() override;
@@ -42,6 +105,22 @@ class OMPStream : public Stream<T>
     virtual void init_arrays(T initA, T initB, T initC) override;
     virtual void read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
 
+    virtual bool set_active_size(const intptr_t n) override;
+    virtual bool set_nontemporal(const bool enable) override;
+    virtual bool set_access_order(const AccessOrder *order) override;
+    virtual bool set_schedule(const LoopSchedule& schedule) override;
+    virtual bool set_instrumented(const bool enable) override;
+    virtual std::vector<ThreadTiming> thread_timings() override;
+    virtual bool set_repeats(const int repeats) override;
+    virtual uint64_t repeat_ticks() override;
+    virtual bool run_persistent(const unsigned int iterations, std::vector<std::vector<double>>& timings, T& sum) override;
+
+    virtual bool set_indices(const std::vector<int>& indices) override;
+    virtual void gather() override;
+    virtual void scatter() override;
 
+    virtual bool verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                        double& errA, double& errB, double& errC) override;
+    virtual bool host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c) override;
 
 };
@@ -0,0 +1,291 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <cstdio>
+#include <unistd.h>
+#include <dirent.h>
+#include <cerrno>
+#endif
+
+#include "sysfs.h"
+
+// Hardware performance counters, read around each kernel with Linux perf_event_open.
+//
+// Core events are opened for every thread of this process (from /proc/self/task), so the
+// worker threads of whichever model is compiled in are counted; they must therefore be
+// opened after the model has started its threads, e.g. after init_arrays.
+// The uncore memory controller (IMC) CAS counters measure the real DRAM traffic and are
+// opened system-wide, which usually needs perf_event_paranoid <= 0 or CAP_PERFMON.
+// Any event that cannot be opened is left out, so this works with whatever is accessible.
+class PerfCounters
+{
+  public:
+    PerfCounters(size_t kernels) : totals(kernels), calls(kernels, 0)
+    {
+#if defined(__linux__)
+      open_core_events();
+      open_imc_events();
+#endif
+      for (std::vector<double>& t : totals)
+        t.assign(events.size(), 0.0);
+      before.assign(events.size(), 0.0);
+    }
+
+    ~PerfCounters()
+    {
+#if defined(__linux__)
+      for (const Event& e : events)
+        for (int fd : e.fds)
+          close(fd);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return !events.empty(); }
+
+    // Names of the events that could be opened, in the order of the values returned by average()
+    std::vector<std::string> names() const
+    {
+      std::vector<std::string> result;
+      for (const Event& e : events)
+        result.push_back(e.name);
+      return result;
+    }
+
+    // Index of the named event, or -1 if it is not available
+    int find(const std::string& name) const
+    {
+      for (size_t i = 0; i < events.size(); i++)
+        if (events[i].name == name)
+          return i;
+      return -1;
+    }
+
+    // Call immediately before and after the timed region of a kernel call
+    void start() { read(before); }
+
+    void stop(size_t kernel)
+    {
+      std::vector<double> after;
+      read(after);
+      for (size_t i = 0; i < events.size(); i++)
+        totals[kernel][i] += after[i] - before[i];
+      calls[kernel]++;
+    }
+
+    // Mean count of each event per call of the given kernel
+    std::vector<double> average(size_t kernel) const
+    {
+      std::vector<double> result(events.size(), 0.0);
+      if (calls[kernel])
+        for (size_t i = 0; i < events.size(); i++)
+          result[i] = totals[kernel][i] / calls[kernel];
+      return result;
+    }
+
+    // Reason no events are available, if any
+    const std::string& error() const { return last_error; }
+
+  private:
+    struct Event
+    {
+      std::string name;
+      std::vector<int> fds;
+      // Multiplier converting a raw count to the reported unit
+      double scale;
+    };
+
+    std::vector<Event> events;
+    std::vector<std::vector<double>> totals;
+    std::vector<size_t> calls;
+    std::vector<double> before;
+    std::string last_error;
+
+#if defined(__linux__)
+    static int perf_event_open(perf_event_attr *attr, pid_t pid, int cpu)
+    {
+      return syscall(SYS_perf_event_open, attr, pid, cpu, -1, 0);
+    }
+
+    static perf_event_attr make_attr(uint32_t type, uint64_t config)
+    {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      // Counters are multiplexed if there are more events than hardware counters
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      return attr;
+    }
+
+    static uint64_t cache_config(uint64_t cache, uint64_t op, uint64_t result)
+    {
+      return cache | (op << 8) | (result << 16);
+    }
+
+    void open_core_events()
+    {
+      std::vector<pid_t> threads;
+      DIR *dir = opendir("/proc/self/task");
+      if (dir)
+      {
+        while (dirent *entry = readdir(dir))
+          if (entry->d_name[0] != '.')
+            threads.push_back(atoi(entry->d_name));
+        closedir(dir);
+      }
+
+      struct { const char *name; uint32_t type; uint64_t config; } core[] = {
+        {"cycles",       PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"llc_misses",   PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {"loads",        PERF_TYPE_HW_CACHE,
+          cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+        {"stores",       PERF_TYPE_HW_CACHE,
+          cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_WRITE, PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+        {"dtlb_misses",  PERF_TYPE_HW_CACHE,
+          cache_config(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {"page_faults",  PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+      };
+
+      for (const auto& c : core)
+      {
+        perf_event_attr attr = make_attr(c.type, c.config);
+        // Unprivileged users can usually only count user space
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        Event e{c.name, {}, 1.0};
+        for (pid_t tid : threads)
+        {
+          int fd = perf_event_open(&attr, tid, -1);
+          if (fd >= 0)
+            e.fds.push_back(fd);
+          else if (e.fds.empty())
+          {
+            // Not supported by this CPU or not permitted; no point trying the other threads
+            last_error = std::string(c.name) + ": " + strerror(errno);
+            break;
+          }
+        }
+        if (!e.fds.empty())
+          events.push_back(e);
+      }
+    }
+
+    static std::string read_line(const std::string& path)
+    {
+      std::ifstream file(path);
+      std::string line;
+      std::getline(file, line);
+      return line;
+    }
+
+    // Encodes an event description such as "event=0x04,umask=0x03" using the PMU's
+    // format/ definitions (e.g. "config:8-15"); only fields of config are supported
+    static bool encode_event(const std::string& pmu, const std::string& desc, uint64_t& config)
+    {
+      config = 0;
+      std::stringstream terms(desc);
+      std::string term;
+      while (std::getline(terms, term, ','))
+      {
+        size_t eq = term.find('=');
+        std::string name = term.substr(0, eq);
+        uint64_t value = (eq == std::string::npos) ? 1 : strtoull(term.c_str() + eq + 1, nullptr, 0);
+
+        std::string format = read_line(pmu + "/format/" + name);
+        unsigned int lo, hi;
+        int fields = sscanf(format.c_str(), "config:%u-%u", &lo, &hi);
+        if (fields < 1)
+          return false;
+        if (fields == 1)
+          hi = lo;
+        uint64_t mask = (hi - lo >= 63) ? ~0ull : ((1ull << (hi - lo + 1)) - 1);
+        config |= (value & mask) << lo;
+      }
+      return true;
+    }
+
+    void open_imc_events()
+    {
+      const std::string root = "/sys/bus/event_source/devices/";
+      std::vector<std::string> pmus;
+      DIR *dir = opendir(root.c_str());
+      if (dir)
+      {
+        while (dirent *entry = readdir(dir))
+          if (!strncmp(entry->d_name, "uncore_imc", 10) && !strstr(entry->d_name, "free_running"))
+            pmus.push_back(root + entry->d_name);
+        closedir(dir);
+      }
+
+      const char *cas[][2] = {{"imc_read_bytes", "cas_count_read"}, {"imc_write_bytes", "cas_count_write"}};
+      for (const auto& c : cas)
+      {
+        Event e{c[0], {}, 64.0};
+        for (const std::string& pmu : pmus)
+        {
+          uint64_t config;
+          std::string desc = read_line(pmu + "/events/" + c[1]);
+          if (desc.empty() || !encode_event(pmu, desc, config))
+            continue;
+
+          // Uncore events are counted per socket, on the CPUs the PMU lists in its cpumask,
+          // one for each socket, and summed; each CAS moves one 64 byte cache line
+          std::vector<int> cpus;
+          if (!parse_id_list(read_line(pmu + "/cpumask"), cpus) || cpus.empty())
+            continue;
+          perf_event_attr attr = make_attr(atoi(read_line(pmu + "/type").c_str()), config);
+          for (int cpu : cpus)
+          {
+            int fd = perf_event_open(&attr, -1, cpu);
+            if (fd >= 0)
+              e.fds.push_back(fd);
+            else
+              last_error = pmu + ": " + strerror(errno);
+          }
+        }
+        if (!e.fds.empty())
+          events.push_back(e);
+      }
+    }
+#endif
+
+    void read(std::vector<double>& values)
+    {
+      values.assign(events.size(), 0.0);
+#if defined(__linux__)
+      for (size_t i = 0; i < events.size(); i++)
+      {
+        for (int fd : events[i].fds)
+        {
+          uint64_t data[3];
+          if (::read(fd, data, sizeof(data)) != sizeof(data) || data[2] == 0)
+            continue;
+          // Scale up if the counter was only running for part of the time
+          values[i] += events[i].scale * data[0] * (static_cast<double>(data[1]) / data[2]);
+        }
+      }
+#endif
+    }
+};
@@ -0,0 +1,42 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+// Entry point of an implementation built as a plugin library for the babelstream driver
+
+#include "plugin.h"
+#include "models.h"
+
+#ifndef BUILD_COMPILER_STRING
+#define BUILD_COMPILER_STRING "unknown"
+#endif
+#ifndef BUILD_FLAGS_STRING
+#define BUILD_FLAGS_STRING "unknown"
+#endif
+
+namespace
+{
+
+Stream<float> *make_float(intptr_t array_size, unsigned int device)
+{
+  return make_model_stream<float>(array_size, device);
+}
+
+Stream<double> *make_double(intptr_t array_size, unsigned int device)
+{
+  return make_model_stream<double>(array_size, device);
+}
+
+}
+
+extern "C" const StreamPlugin *babelstream_plugin()
+{
+  static const StreamPlugin plugin = {
+    STREAM_PLUGIN_VERSION, IMPLEMENTATION_STRING, BUILD_COMPILER_STRING, BUILD_FLAGS_STRING,
+    make_float, make_double,
+    listDevices, getDeviceName, getDeviceDriver, getDeviceMemory
+  };
+  return &plugin;
+}
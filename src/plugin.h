@@ -0,0 +1,54 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <string>
+
+#include "Stream.h"
+
+// Interface between the babelstream driver and an implementation built as a plugin library
+// (configured with -DPLUGIN=ON). The library exports STREAM_PLUGIN_SYMBOL, which returns a
+// description of the implementation it was built with and factories for its streams.
+// The version is bumped whenever this struct or Stream<T> changes.
+#define STREAM_PLUGIN_VERSION 11
+#define STREAM_PLUGIN_SYMBOL "babelstream_plugin"
+
+struct StreamPlugin
+{
+  int version;
+  // IMPLEMENTATION_STRING of the implementation
+  const char *implementation;
+  // Compiler and flags the library was built with
+  const char *compiler;
+  const char *flags;
+
+  Stream<float> *(*make_float)(intptr_t array_size, unsigned int device);
+  Stream<double> *(*make_double)(intptr_t array_size, unsigned int device);
+
+  // The implementation's listDevices, getDeviceName, getDeviceDriver and getDeviceMemory
+  void (*list_devices)();
+  std::string (*device_name)(int device);
+  std::string (*device_driver)(int device);
+  bool (*device_memory)(int device, size_t& memory, size_t& cache);
+};
+
+typedef const StreamPlugin *(*StreamPluginEntry)();
+
+template <typename T>
+Stream<T> *plugin_stream(const StreamPlugin& plugin, intptr_t array_size, unsigned int device);
+
+template <>
+inline Stream<float> *plugin_stream<float>(const StreamPlugin& plugin, intptr_t array_size, unsigned int device)
+{
+  return plugin.make_float(array_size, device);
+}
+
+template <>
+inline Stream<double> *plugin_stream<double>(const StreamPlugin& plugin, intptr_t array_size, unsigned int device)
+{
+  return plugin.make_double(array_size, device);
+}
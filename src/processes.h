@@ -0,0 +1,137 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <chrono>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/mman.h>
+#endif
+
+// Shared state of the worker processes of --processes, set up by the parent before it forks:
+// a barrier all the workers wait on before each kernel, so that they load the memory system at
+// the same time as the ranks of an MPI job would, and room for the start and end of every kernel
+// call of each worker, which the parent reads once they have exited. The times are taken from
+// steady_clock, which is the same clock in every process, so the calls of different workers
+// can be compared.
+class ProcessGroup
+{
+  public:
+    ProcessGroup(int processes, size_t kernels, size_t iterations)
+      : processes(processes), iterations(iterations), values_per_process(2 * kernels * iterations),
+        memory(nullptr), bytes(0)
+    {
+#if defined(__linux__)
+      // The values follow the barrier, aligned for doubles
+      const size_t header = (sizeof(pthread_barrier_t) + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+      bytes = header + processes * values_per_process * sizeof(double);
+      void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED)
+        return;
+
+      pthread_barrierattr_t attr;
+      pthread_barrierattr_init(&attr);
+      pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+      int err = pthread_barrier_init(static_cast<pthread_barrier_t *>(p), &attr, processes);
+      pthread_barrierattr_destroy(&attr);
+      if (err != 0)
+      {
+        munmap(p, bytes);
+        return;
+      }
+      memory = static_cast<char *>(p);
+      values = reinterpret_cast<double *>(memory + header);
+#endif
+    }
+
+    ~ProcessGroup()
+    {
+#if defined(__linux__)
+      // The workers leave with _exit, so this runs in the parent once they are all gone
+      if (memory)
+      {
+        pthread_barrier_destroy(reinterpret_cast<pthread_barrier_t *>(memory));
+        munmap(memory, bytes);
+      }
+#endif
+    }
+
+    ProcessGroup(const ProcessGroup&) = delete;
+    ProcessGroup& operator=(const ProcessGroup&) = delete;
+
+    // Whether the shared memory and the barrier could be set up
+    bool available() const
+    {
+      return memory != nullptr;
+    }
+
+    // Returns once all the processes of the group have called it
+    void wait()
+    {
+#if defined(__linux__)
+      pthread_barrier_wait(reinterpret_cast<pthread_barrier_t *>(memory));
+#endif
+    }
+
+    // Called by each worker after the fork with its index in the group
+    void join(int p)
+    {
+      rank = p;
+    }
+
+    // Called by the workers immediately before and after each call of a kernel: start returns once
+    // every worker is ready to start the call
+    void start(size_t kernel, unsigned int iteration)
+    {
+      wait();
+      stamp(rank, kernel, iteration)[0] = now();
+    }
+
+    void stop(size_t kernel, unsigned int iteration)
+    {
+      stamp(rank, kernel, iteration)[1] = now();
+    }
+
+    // Seconds from an arbitrary point at which process p started and finished the given call
+    double start_time(int p, size_t kernel, unsigned int iteration)
+    {
+      return stamp(p, kernel, iteration)[0];
+    }
+
+    double end_time(int p, size_t kernel, unsigned int iteration)
+    {
+      return stamp(p, kernel, iteration)[1];
+    }
+
+    int size() const
+    {
+      return processes;
+    }
+
+  private:
+    int processes;
+    size_t iterations;
+    size_t values_per_process;
+    char *memory;
+    size_t bytes;
+    double *values = nullptr;
+    int rank = 0;
+
+    double *stamp(int p, size_t kernel, unsigned int iteration)
+    {
+      return values + p * values_per_process + 2 * (kernel * iterations + iteration);
+    }
+
+    static double now()
+    {
+      return std::chrono::duration_cast<std::chrono::duration<double> >(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
@@ -159,5 +159,16 @@ std::string getDeviceDriver(const int device)
   return "RAJA";
 }
 
+bool getDeviceMemory(const int, size_t& memory, size_t& cache)
+{
+#ifdef RAJA_TARGET_CPU
+  return false;
+#else
+  // RAJA has no query for the memory of a device
+  memory = cache = 0;
+  return true;
+#endif
+}
+
 template class RAJAStream<float>;
 template class RAJAStream<double>;
@@ -0,0 +1,439 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#include "SIMDStream.h"
+#include "host_alloc.h"
+
+#include <vector>
+#include <cmath>
+#include <omp.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SIMD_NEON
+#endif
+
+// Vector operations for each instruction set. Every member carries the same target
+// attribute as the kernels using it, so the whole file builds without -march flags and
+// the instruction set is chosen at runtime.
+
+// Plain C++, used where there are no intrinsics and to check the others
+template <class T>
+struct ScalarVector
+{
+  typedef T type;
+  static const int width = 1;
+  static type load(const T *p) { return *p; }
+  static void store(T *p, type x) { *p = x; }
+  static type set1(T x) { return x; }
+  static type add(type x, type y) { return x + y; }
+  static type mul(type x, type y) { return x * y; }
+  static type fmadd(type x, type y, type z) { return x * y + z; }
+  static T reduce(type x) { return x; }
+};
+
+// Horizontal sum of a vector of either type, by way of memory
+template <class V, class T>
+inline T reduce_via_memory(const typename V::type& x)
+{
+  T lanes[V::width];
+  V::store(lanes, x);
+  T sum = 0;
+  for (int i = 0; i < V::width; i++)
+    sum += lanes[i];
+  return sum;
+}
+
+#if defined(SIMD_X86)
+
+#define SSE2_TARGET
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+template <class T> struct SSE2Vector;
+template <class T> struct AVX2Vector;
+template <class T> struct AVX512Vector;
+
+template <> struct SSE2Vector<double>
+{
+  typedef __m128d type;
+  static const int width = 2;
+  static type load(const double *p) { return _mm_loadu_pd(p); }
+  static void store(double *p, type x) { _mm_storeu_pd(p, x); }
+  static type set1(double x) { return _mm_set1_pd(x); }
+  static type add(type x, type y) { return _mm_add_pd(x, y); }
+  static type mul(type x, type y) { return _mm_mul_pd(x, y); }
+  static type fmadd(type x, type y, type z) { return _mm_add_pd(_mm_mul_pd(x, y), z); }
+  static double reduce(type x) { return reduce_via_memory<SSE2Vector, double>(x); }
+};
+
+template <> struct SSE2Vector<float>
+{
+  typedef __m128 type;
+  static const int width = 4;
+  static type load(const float *p) { return _mm_loadu_ps(p); }
+  static void store(float *p, type x) { _mm_storeu_ps(p, x); }
+  static type set1(float x) { return _mm_set1_ps(x); }
+  static type add(type x, type y) { return _mm_add_ps(x, y); }
+  static type mul(type x, type y) { return _mm_mul_ps(x, y); }
+  static type fmadd(type x, type y, type z) { return _mm_add_ps(_mm_mul_ps(x, y), z); }
+  static float reduce(type x) { return reduce_via_memory<SSE2Vector, float>(x); }
+};
+
+template <> struct AVX2Vector<double>
+{
+  typedef __m256d type;
+  static const int width = 4;
+  AVX2_TARGET static type load(const double *p) { return _mm256_loadu_pd(p); }
+  AVX2_TARGET static void store(double *p, type x) { _mm256_storeu_pd(p, x); }
+  AVX2_TARGET static type set1(double x) { return _mm256_set1_pd(x); }
+  AVX2_TARGET static type add(type x, type y) { return _mm256_add_pd(x, y); }
+  AVX2_TARGET static type mul(type x, type y) { return _mm256_mul_pd(x, y); }
+  AVX2_TARGET static type fmadd(type x, type y, type z) { return _mm256_fmadd_pd(x, y, z); }
+  AVX2_TARGET static double reduce(type x) { return reduce_via_memory<AVX2Vector, double>(x); }
+};
+
+template <> struct AVX2Vector<float>
+{
+  typedef __m256 type;
+  static const int width = 8;
+  AVX2_TARGET static type load(const float *p) { return _mm256_loadu_ps(p); }
+  AVX2_TARGET static void store(float *p, type x) { _mm256_storeu_ps(p, x); }
+  AVX2_TARGET static type set1(float x) { return _mm256_set1_ps(x); }
+  AVX2_TARGET static type add(type x, type y) { return _mm256_add_ps(x, y); }
+  AVX2_TARGET static type mul(type x, type y) { return _mm256_mul_ps(x, y); }
+  AVX2_TARGET static type fmadd(type x, type y, type z) { return _mm256_fmadd_ps(x, y, z); }
+  AVX2_TARGET static float reduce(type x) { return reduce_via_memory<AVX2Vector, float>(x); }
+};
+
+template <> struct AVX512Vector<double>
+{
+  typedef __m512d type;
+  static const int width = 8;
+  AVX512_TARGET static type load(const double *p) { return _mm512_loadu_pd(p); }
+  AVX512_TARGET static void store(double *p, type x) { _mm512_storeu_pd(p, x); }
+  AVX512_TARGET static type set1(double x) { return _mm512_set1_pd(x); }
+  AVX512_TARGET static type add(type x, type y) { return _mm512_add_pd(x, y); }
+  AVX512_TARGET static type mul(type x, type y) { return _mm512_mul_pd(x, y); }
+  AVX512_TARGET static type fmadd(type x, type y, type z) { return _mm512_fmadd_pd(x, y, z); }
+  AVX512_TARGET static double reduce(type x) { return _mm512_reduce_add_pd(x); }
+};
+
+template <> struct AVX512Vector<float>
+{
+  typedef __m512 type;
+  static const int width = 16;
+  AVX512_TARGET static type load(const float *p) { return _mm512_loadu_ps(p); }
+  AVX512_TARGET static void store(float *p, type x) { _mm512_storeu_ps(p, x); }
+  AVX512_TARGET static type set1(float x) { return _mm512_set1_ps(x); }
+  AVX512_TARGET static type add(type x, type y) { return _mm512_add_ps(x, y); }
+  AVX512_TARGET static type mul(type x, type y) { return _mm512_mul_ps(x, y); }
+  AVX512_TARGET static type fmadd(type x, type y, type z) { return _mm512_fmadd_ps(x, y, z); }
+  AVX512_TARGET static float reduce(type x) { return _mm512_reduce_add_ps(x); }
+};
+
+#define SIMD_NAMESPACE avx512
+#define SIMD_TARGET AVX512_TARGET
+#define SIMD_VECTOR AVX512Vector
+#include "SIMDKernels.inc"
+#undef SIMD_NAMESPACE
+#undef SIMD_TARGET
+#undef SIMD_VECTOR
+
+#define SIMD_NAMESPACE avx2
+#define SIMD_TARGET AVX2_TARGET
+#define SIMD_VECTOR AVX2Vector
+#include "SIMDKernels.inc"
+#undef SIMD_NAMESPACE
+#undef SIMD_TARGET
+#undef SIMD_VECTOR
+
+#define SIMD_NAMESPACE sse2
+#define SIMD_TARGET SSE2_TARGET
+#define SIMD_VECTOR SSE2Vector
+#include "SIMDKernels.inc"
+#undef SIMD_NAMESPACE
+#undef SIMD_TARGET
+#undef SIMD_VECTOR
+
+#elif defined(SIMD_NEON)
+
+// Advanced SIMD is part of the base AArch64 architecture, so needs no runtime check
+template <class T> struct NEONVector;
+
+template <> struct NEONVector<double>
+{
+  typedef float64x2_t type;
+  static const int width = 2;
+  static type load(const double *p) { return vld1q_f64(p); }
+  static void store(double *p, type x) { vst1q_f64(p, x); }
+  static type set1(double x) { return vdupq_n_f64(x); }
+  static type add(type x, type y) { return vaddq_f64(x, y); }
+  static type mul(type x, type y) { return vmulq_f64(x, y); }
+  static type fmadd(type x, type y, type z) { return vfmaq_f64(z, x, y); }
+  static double reduce(type x) { return vaddvq_f64(x); }
+};
+
+template <> struct NEONVector<float>
+{
+  typedef float32x4_t type;
+  static const int width = 4;
+  static type load(const float *p) { return vld1q_f32(p); }
+  static void store(float *p, type x) { vst1q_f32(p, x); }
+  static type set1(float x) { return vdupq_n_f32(x); }
+  static type add(type x, type y) { return vaddq_f32(x, y); }
+  static type mul(type x, type y) { return vmulq_f32(x, y); }
+  static type fmadd(type x, type y, type z) { return vfmaq_f32(z, x, y); }
+  static float reduce(type x) { return vaddvq_f32(x); }
+};
+
+#define SIMD_NAMESPACE neon
+#define SIMD_TARGET
+#define SIMD_VECTOR NEONVector
+#include "SIMDKernels.inc"
+#undef SIMD_NAMESPACE
+#undef SIMD_TARGET
+#undef SIMD_VECTOR
+
+#endif
+
+#define SIMD_NAMESPACE scalar
+#define SIMD_TARGET
+#define SIMD_VECTOR ScalarVector
+#include "SIMDKernels.inc"
+#undef SIMD_NAMESPACE
+#undef SIMD_TARGET
+#undef SIMD_VECTOR
+
+// The kernels this CPU can run, widest vectors first
+template <class T>
+std::vector<SIMDKernels<T>> available_kernels()
+{
+  std::vector<SIMDKernels<T>> available;
+#if defined(SIMD_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    available.push_back(avx512::kernels<T>("AVX-512"));
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    available.push_back(avx2::kernels<T>("AVX2"));
+  available.push_back(sse2::kernels<T>("SSE2"));
+#elif defined(SIMD_NEON)
+  available.push_back(neon::kernels<T>("NEON"));
+#endif
+  available.push_back(scalar::kernels<T>("Scalar"));
+  return available;
+}
+
+// The block of [0, n) handled by the calling thread. It is the same for every kernel and for
+// init_arrays, so each thread works on the pages it touched first.
+static void thread_block(intptr_t n, intptr_t& begin, intptr_t& end)
+{
+  const int threads = omp_get_num_threads();
+  const int thread = omp_get_thread_num();
+  begin = n * thread / threads;
+  end = n * (thread + 1) / threads;
+}
+
+template <class T>
+SIMDStream<T>::SIMDStream(const intptr_t ARRAY_SIZE, int device)
+{
+  std::vector<SIMDKernels<T>> available = available_kernels<T>();
+  if (device < 0 || device >= static_cast<int>(available.size()))
+    throw std::runtime_error("Invalid device index: this CPU supports " +
+                             std::to_string(available.size()) + " instruction sets");
+  kernels = available[device];
+  std::cout << "Using instruction set: " << kernels.name << std::endl;
+
+  array_size = ARRAY_SIZE;
+  alloc_size = ARRAY_SIZE;
+
+  // Allocate on the host, placed according to the NUMA policy
+  a = host_alloc<T>(array_size);
+  b = host_alloc<T>(array_size);
+  c = host_alloc<T>(array_size);
+}
+
+template <class T>
+SIMDStream<T>::~SIMDStream()
+{
+  host_free(a);
+  host_free(b);
+  host_free(c);
+}
+
+template <class T>
+void SIMDStream<T>::init_arrays(T initA, T initB, T initC)
+{
+  #pragma omp parallel
+  {
+    intptr_t begin, end;
+    thread_block(array_size, begin, end);
+    for (intptr_t i = begin; i < end; i++)
+    {
+      a[i] = initA;
+      b[i] = initB;
+      c[i] = initC;
+    }
+  }
+}
+
+template <class T>
+void SIMDStream<T>::read_arrays(std::vector<T>& h_a, std::vector<T>& h_b, std::vector<T>& h_c)
+{
+  #pragma omp parallel
+  {
+    intptr_t begin, end;
+    thread_block(array_size, begin, end);
+    for (intptr_t i = begin; i < end; i++)
+    {
+      h_a[i] = a[i];
+      h_b[i] = b[i];
+      h_c[i] = c[i];
+    }
+  }
+}
+
+template <class T>
+bool SIMDStream<T>::set_active_size(const intptr_t n)
+{
+  if (n > alloc_size)
+    return false;
+  array_size = n;
+  return true;
+}
+
+template <class T>
+void SIMDStream<T>::copy()
+{
+  #pragma omp parallel
+  {
+    intptr_t begin, end;
+    thread_block(array_size, begin, end);
+    kernels.copy(a, c, begin, end);
+  }
+}
+
+template <class T>
+void SIMDStream<T>::mul()
+{
+  #pragma omp parallel
+  {
+    intptr_t begin, end;
+    thread_block(array_size, begin, end);
+    kernels.mul(b, c, startScalar, begin, end);
+  }
+}
+
+template <class T>
+void SIMDStream<T>::add()
+{
+  #pragma omp parallel
+  {
+    intptr_t begin, end;
+    thread_block(array_size, begin, end);
+    kernels.add(a, b, c, begin, end);
+  }
+}
+
+template <class T>
+void SIMDStream<T>::triad()
+{
+  #pragma omp parallel
+  {
+    intptr_t begin, end;
+    thread_block(array_size, begin, end);
+    kernels.triad(a, b, c, startScalar, begin, end);
+  }
+}
+
+template <class T>
+void SIMDStream<T>::nstream()
+{
+  #pragma omp parallel
+  {
+    intptr_t begin, end;
+    thread_block(array_size, begin, end);
+    kernels.nstream(a, b, c, startScalar, begin, end);
+  }
+}
+
+template <class T>
+T SIMDStream<T>::dot()
+{
+  T sum{};
+
+  #pragma omp parallel reduction(+:sum)
+  {
+    intptr_t begin, end;
+    thread_block(array_size, begin, end);
+    sum += kernels.dot(a, b, begin, end);
+  }
+
+  return sum;
+}
+
+template <class T>
+bool SIMDStream<T>::verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                           double& errA, double& errB, double& errC)
+{
+  double sumA = 0.0, sumB = 0.0, sumC = 0.0;
+
+  #pragma omp parallel for reduction(+:sumA, sumB, sumC)
+  for (intptr_t i = 0; i < array_size; i += stride)
+  {
+    sumA += std::fabs(a[i] - goldA);
+    sumB += std::fabs(b[i] - goldB);
+    sumC += std::fabs(c[i] - goldC);
+  }
+
+  const intptr_t n = (array_size + stride - 1) / stride;
+  errA = sumA / n;
+  errB = sumB / n;
+  errC = sumC / n;
+  return true;
+}
+
+template <class T>
+bool SIMDStream<T>::host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c)
+{
+  a = {this->a, array_size};
+  b = {this->b, array_size};
+  c = {this->c, array_size};
+  return true;
+}
+
+void listDevices(void)
+{
+  // The "devices" are the instruction sets of this CPU
+  std::vector<SIMDKernels<double>> available = available_kernels<double>();
+  std::cout << "Devices:" << std::endl;
+  for (size_t i = 0; i < available.size(); i++)
+    std::cout << i << ": " << available[i].name << std::endl;
+}
+
+std::string getDeviceName(const int device)
+{
+  std::vector<SIMDKernels<double>> available = available_kernels<double>();
+  if (device < 0 || device >= static_cast<int>(available.size()))
+    return std::string("Device name unavailable");
+  return std::string(available[device].name) + " on " + std::to_string(omp_get_max_threads()) + " threads";
+}
+
+std::string getDeviceDriver(const int)
+{
+  return std::string("Device driver unavailable");
+}
+
+bool getDeviceMemory(const int, size_t&, size_t&)
+{
+  return false;
+}
+
+template class SIMDStream<float>;
+template class SIMDStream<double>;
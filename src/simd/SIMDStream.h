@@ -0,0 +1,67 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "Stream.h"
+
+#define IMPLEMENTATION_STRING "SIMD"
+
+// Kernels over the elements [begin, end) for one instruction set
+template <class T>
+struct SIMDKernels
+{
+  const char *name;
+  void (*copy)(const T *a, T *c, intptr_t begin, intptr_t end);
+  void (*mul)(T *b, const T *c, T scalar, intptr_t begin, intptr_t end);
+  void (*add)(const T *a, const T *b, T *c, intptr_t begin, intptr_t end);
+  void (*triad)(T *a, const T *b, const T *c, T scalar, intptr_t begin, intptr_t end);
+  void (*nstream)(T *a, const T *b, const T *c, T scalar, intptr_t begin, intptr_t end);
+  T (*dot)(const T *a, const T *b, intptr_t begin, intptr_t end);
+};
+
+// Explicitly vectorised kernels, with the instruction set chosen at runtime.
+// The device index selects from the instruction sets this CPU supports, widest first.
+// Each OpenMP thread runs the kernels on its own static block of the arrays.
+template <class T>
+class SIMDStream : public Stream<T>
+{
+  protected:
+    // Size of arrays, and the number of elements actually allocated
+    intptr_t array_size;
+    intptr_t alloc_size;
+
+    T *a;
+    T *b;
+    T *c;
+
+    SIMDKernels<T> kernels;
+
+  public:
+    SIMDStream(const intptr_t, int);
+    ~SIMDStream();
+
+    virtual void copy() override;
+    virtual void add() override;
+    virtual void mul() override;
+    virtual void triad() override;
+    virtual void nstream() override;
+    virtual T dot() override;
+
+    virtual void init_arrays(T initA, T initB, T initC) override;
+    virtual void read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
+
+    virtual bool set_active_size(const intptr_t n) override;
+
+    virtual bool verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                        double& errA, double& errB, double& errC) override;
+    virtual bool host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c) override;
+
+};
@@ -0,0 +1,10 @@
+
+register_flag_optional(CMAKE_CXX_COMPILER
+        "Any CXX compiler that supports OpenMP and GCC-style target attributes (e.g. GCC, Clang or icpx).
+         No architecture flags are needed: the instruction set is selected at runtime, see --list."
+        "c++")
+
+macro(setup)
+    find_package(OpenMP REQUIRED)
+    register_link_library(OpenMP::OpenMP_CXX)
+endmacro()
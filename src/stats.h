@@ -0,0 +1,95 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cmath>
+
+// Summary statistics of a set of kernel runtimes, in seconds
+struct TimingStats
+{
+  size_t count;
+  double min, max, mean, median, stddev;
+  double p5, p95, p99;
+  // Bootstrap confidence interval of the median
+  double ci_low, ci_high;
+};
+
+// Linearly interpolated percentile (0 to 100) of an ascending list of samples
+inline double percentile(const std::vector<double>& sorted, double p)
+{
+  if (sorted.size() == 1)
+    return sorted[0];
+  double rank = p / 100.0 * (sorted.size() - 1);
+  size_t lower = static_cast<size_t>(rank);
+  if (lower + 1 >= sorted.size())
+    return sorted.back();
+  return sorted[lower] + (rank - lower) * (sorted[lower + 1] - sorted[lower]);
+}
+
+inline double median(std::vector<double>& samples)
+{
+  size_t half = samples.size() / 2;
+  std::nth_element(samples.begin(), samples.begin() + half, samples.end());
+  double upper = samples[half];
+  if (samples.size() % 2)
+    return upper;
+  return 0.5 * (upper + *std::max_element(samples.begin(), samples.begin() + half));
+}
+
+// Percentile bootstrap confidence interval of the median.
+// A fixed seed is used so that the same timings always give the same interval.
+inline void bootstrap_median_ci(const std::vector<double>& samples, double confidence,
+                                unsigned int resamples, double& low, double& high)
+{
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+
+  std::vector<double> medians(resamples);
+  std::vector<double> resample(samples.size());
+  for (unsigned int r = 0; r < resamples; r++)
+  {
+    for (size_t i = 0; i < resample.size(); i++)
+      resample[i] = samples[pick(rng)];
+    medians[r] = median(resample);
+  }
+
+  std::sort(medians.begin(), medians.end());
+  double tail = 50.0 * (1.0 - confidence);
+  low = percentile(medians, tail);
+  high = percentile(medians, 100.0 - tail);
+}
+
+// Summarise the runtimes in [first, last), which must not be empty
+template <typename It>
+TimingStats compute_stats(It first, It last, double confidence = 0.95, unsigned int resamples = 1000)
+{
+  std::vector<double> sorted(first, last);
+  std::sort(sorted.begin(), sorted.end());
+
+  TimingStats stats;
+  stats.count = sorted.size();
+  stats.min = sorted.front();
+  stats.max = sorted.back();
+  stats.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+
+  double sq = 0.0;
+  for (double t : sorted)
+    sq += (t - stats.mean) * (t - stats.mean);
+  stats.stddev = sorted.size() > 1 ? std::sqrt(sq / (sorted.size() - 1)) : 0.0;
+
+  stats.median = percentile(sorted, 50.0);
+  stats.p5 = percentile(sorted, 5.0);
+  stats.p95 = percentile(sorted, 95.0);
+  stats.p99 = percentile(sorted, 99.0);
+
+  bootstrap_median_ci(sorted, confidence, resamples, stats.ci_low, stats.ci_high);
+  return stats;
+}
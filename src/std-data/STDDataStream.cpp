@@ -7,8 +7,8 @@
 #include "STDDataStream.h"
 
 template <class T>
-STDDataStream<T>::STDDataStream(const int ARRAY_SIZE, int device)
-  noexcept : array_size{ARRAY_SIZE},
+STDDataStream<T>::STDDataStream(const intptr_t ARRAY_SIZE, int device)
+  noexcept : array_size{ARRAY_SIZE}, alloc_size{ARRAY_SIZE},
   a(alloc_raw<T>(ARRAY_SIZE)), b(alloc_raw<T>(ARRAY_SIZE)), c(alloc_raw<T>(ARRAY_SIZE))
 {
     std::cout << "Backing storage typeid: " << typeid(a).name() << std::endl;
@@ -50,6 +50,15 @@ void STDDataStream<T>::read_arrays(std::vector<T>& h_a, std::vector<T>& h_b, std
   std::copy(c, c + array_size, h_c.begin());
 }
 
+template <class T>
+bool STDDataStream<T>::set_active_size(const intptr_t n)
+{
+  if (n > alloc_size)
+    return false;
+  array_size = n;
+  return true;
+}
+
 template <class T>
 void STDDataStream<T>::copy()
 {
@@ -97,6 +106,47 @@ T STDDataStream<T>::dot()
   return std::transform_reduce(exe_policy, a, a + array_size, b, T{});
 }
 
+template <class T>
+bool STDDataStream<T>::verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                              double& errA, double& errB, double& errC)
+{
+  if (stride == 1)
+  {
+    errA = std::transform_reduce(exe_policy, a, a + array_size, 0.0, std::plus<double>(), [=](T ai){ return std::fabs(ai - goldA); }) / array_size;
+    errB = std::transform_reduce(exe_policy, b, b + array_size, 0.0, std::plus<double>(), [=](T bi){ return std::fabs(bi - goldB); }) / array_size;
+    errC = std::transform_reduce(exe_policy, c, c + array_size, 0.0, std::plus<double>(), [=](T ci){ return std::fabs(ci - goldC); }) / array_size;
+    return true;
+  }
+
+  // A sample is small enough to check on the calling thread
+  double sumA = 0.0, sumB = 0.0, sumC = 0.0;
+  for (intptr_t i = 0; i < array_size; i += stride)
+  {
+    sumA += std::fabs(a[i] - goldA);
+    sumB += std::fabs(b[i] - goldB);
+    sumC += std::fabs(c[i] - goldC);
+  }
+  const intptr_t n = (array_size + stride - 1) / stride;
+  errA = sumA / n;
+  errB = sumB / n;
+  errC = sumC / n;
+  return true;
+}
+
+template <class T>
+bool STDDataStream<T>::host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c)
+{
+#if defined(STD_HOST_ARRAYS)
+  a = {this->a, array_size};
+  b = {this->b, array_size};
+  c = {this->c, array_size};
+  return true;
+#else
+  // Shared memory that may be on the device; reading it from the host would migrate it
+  return false;
+#endif
+}
+
 void listDevices(void)
 {
   std::cout << "Listing devices is not supported by the Parallel STL" << std::endl;
@@ -111,5 +161,16 @@ std::string getDeviceDriver(const int)
 {
   return std::string("Device driver unavailable");
 }
+
+bool getDeviceMemory(const int, size_t& memory, size_t& cache)
+{
+#if defined(STD_HOST_ARRAYS)
+  return false;
+#else
+  // Neither oneDPL nor stdpar report the memory of the device
+  memory = cache = 0;
+  return true;
+#endif
+}
 template class STDDataStream<float>;
 template class STDDataStream<double>;
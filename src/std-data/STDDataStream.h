@@ -9,6 +9,7 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <cmath>
 #include "Stream.h"
 
 #define IMPLEMENTATION_STRING "STD (data-oriented)"
@@ -18,14 +19,15 @@ template <class T>
 class STDDataStream : public Stream<T>
 {
   protected:
-    // Size of arrays
-    int array_size;
+    // Size of arrays, and the number of elements actually allocated
+    intptr_t array_size;
+    intptr_t alloc_size;
 
     // Device side pointers
     T *a, *b, *c;
 
   public:
-    STDDataStream(const int, int) noexcept;
+    STDDataStream(const intptr_t, int) noexcept;
     ~STDDataStream();
 
     virtual void copy() override;
@@ -37,5 +39,11 @@ class STDDataStream : public Stream<T>
 
     virtual void init_arrays(T initA, T initB, T initC) override;
     virtual void read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
+
+    virtual bool set_active_size(const intptr_t n) override;
+
+    virtual bool verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                        double& errA, double& errB, double& errC) override;
+    virtual bool host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c) override;
 };
 
@@ -11,8 +11,8 @@
 #endif
 
 template <class T>
-STDIndicesStream<T>::STDIndicesStream(const int ARRAY_SIZE, int device)
-noexcept : array_size{ARRAY_SIZE}, range(0, array_size),
+STDIndicesStream<T>::STDIndicesStream(const intptr_t ARRAY_SIZE, int device)
+noexcept : array_size{ARRAY_SIZE}, alloc_size{ARRAY_SIZE}, range(0, array_size),
   a(alloc_raw<T>(ARRAY_SIZE)), b(alloc_raw<T>(ARRAY_SIZE)), c(alloc_raw<T>(ARRAY_SIZE))
 {
     std::cout << "Backing storage typeid: " << typeid(a).name() << std::endl;
@@ -36,6 +36,8 @@ STDIndicesStream<T>::~STDIndicesStream() {
   dealloc_raw(a);
   dealloc_raw(b);
   dealloc_raw(c);
+  if (indices)
+    dealloc_raw(indices);
 }
 
 template <class T>
@@ -54,6 +56,45 @@ void STDIndicesStream<T>::read_arrays(std::vector<T>& h_a, std::vector<T>& h_b,
   std::copy(c, c + array_size, h_c.begin());
 }
 
+template <class T>
+bool STDIndicesStream<T>::set_active_size(const intptr_t n)
+{
+  if (n > alloc_size)
+    return false;
+  array_size = n;
+  range = ranged<intptr_t>(0, n);
+  return true;
+}
+
+template <class T>
+bool STDIndicesStream<T>::set_indices(const std::vector<int>& h_indices)
+{
+  if (h_indices.size() > static_cast<size_t>(alloc_size))
+    return false;
+  if (!indices)
+    indices = alloc_raw<int>(alloc_size);
+  std::copy(h_indices.begin(), h_indices.end(), indices);
+  return true;
+}
+
+template <class T>
+void STDIndicesStream<T>::gather()
+{
+  //  a[i] = b[idx[i]];
+  std::transform(exe_policy, range.begin(), range.end(), a, [b = this->b, idx = this->indices](intptr_t i) {
+    return b[idx[i]];
+  });
+}
+
+template <class T>
+void STDIndicesStream<T>::scatter()
+{
+  //  a[idx[i]] = b[i];
+  std::for_each(exe_policy, range.begin(), range.end(), [a = this->a, b = this->b, idx = this->indices](intptr_t i) {
+    a[idx[i]] = b[i];
+  });
+}
+
 template <class T>
 void STDIndicesStream<T>::copy()
 {
@@ -65,7 +106,7 @@ template <class T>
 void STDIndicesStream<T>::mul()
 {
   //  b[i] = scalar * c[i];
-  std::transform(exe_policy, range.begin(), range.end(), b, [c = this->c, scalar = startScalar](int i) {
+  std::transform(exe_policy, range.begin(), range.end(), b, [c = this->c, scalar = startScalar](intptr_t i) {
     return scalar * c[i];
   });
 }
@@ -74,7 +115,7 @@ template <class T>
 void STDIndicesStream<T>::add()
 {
   //  c[i] = a[i] + b[i];
-  std::transform(exe_policy, range.begin(), range.end(), c, [a = this->a, b = this->b](int i) {
+  std::transform(exe_policy, range.begin(), range.end(), c, [a = this->a, b = this->b](intptr_t i) {
     return a[i] + b[i];
   });
 }
@@ -83,7 +124,7 @@ template <class T>
 void STDIndicesStream<T>::triad()
 {
   //  a[i] = b[i] + scalar * c[i];
-  std::transform(exe_policy, range.begin(), range.end(), a, [b = this->b, c = this->c, scalar = startScalar](int i) {
+  std::transform(exe_policy, range.begin(), range.end(), a, [b = this->b, c = this->c, scalar = startScalar](intptr_t i) {
     return b[i] + scalar * c[i];
   });
 }
@@ -95,7 +136,7 @@ void STDIndicesStream<T>::nstream()
   //  Need to do in two stages with C++11 STL.
   //  1: a[i] += b[i]
   //  2: a[i] += scalar * c[i];
-  std::transform(exe_policy, range.begin(), range.end(), a, [a = this->a, b = this->b, c = this->c, scalar = startScalar](int i) {
+  std::transform(exe_policy, range.begin(), range.end(), a, [a = this->a, b = this->b, c = this->c, scalar = startScalar](intptr_t i) {
     return a[i] + b[i] + scalar * c[i];
   });
 }
@@ -108,6 +149,38 @@ T STDIndicesStream<T>::dot()
   return std::transform_reduce(exe_policy, a, a + array_size, b, T{});
 }
 
+template <class T>
+bool STDIndicesStream<T>::verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                                 double& errA, double& errB, double& errC)
+{
+  const intptr_t n = (array_size + stride - 1) / stride;
+  ranged<intptr_t> samples(0, n);
+  errA = std::transform_reduce(exe_policy, samples.begin(), samples.end(), 0.0, std::plus<double>(), [a = this->a, stride, goldA](intptr_t k) {
+    return std::fabs(a[k * stride] - goldA);
+  }) / n;
+  errB = std::transform_reduce(exe_policy, samples.begin(), samples.end(), 0.0, std::plus<double>(), [b = this->b, stride, goldB](intptr_t k) {
+    return std::fabs(b[k * stride] - goldB);
+  }) / n;
+  errC = std::transform_reduce(exe_policy, samples.begin(), samples.end(), 0.0, std::plus<double>(), [c = this->c, stride, goldC](intptr_t k) {
+    return std::fabs(c[k * stride] - goldC);
+  }) / n;
+  return true;
+}
+
+template <class T>
+bool STDIndicesStream<T>::host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c)
+{
+#if defined(STD_HOST_ARRAYS)
+  a = {this->a, array_size};
+  b = {this->b, array_size};
+  c = {this->c, array_size};
+  return true;
+#else
+  // Shared memory that may be on the device; reading it from the host would migrate it
+  return false;
+#endif
+}
+
 void listDevices(void)
 {
   std::cout << "Listing devices is not supported by the Parallel STL" << std::endl;
@@ -122,5 +195,16 @@ std::string getDeviceDriver(const int)
 {
   return std::string("Device driver unavailable");
 }
+
+bool getDeviceMemory(const int, size_t& memory, size_t& cache)
+{
+#if defined(STD_HOST_ARRAYS)
+  return false;
+#else
+  // Neither oneDPL nor stdpar report the memory of the device
+  memory = cache = 0;
+  return true;
+#endif
+}
 template class STDIndicesStream<float>;
 template class STDIndicesStream<double>;
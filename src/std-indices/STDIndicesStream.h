@@ -9,6 +9,7 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <cmath>
 #include "Stream.h"
 
 #define IMPLEMENTATION_STRING "STD (index-oriented)"
@@ -70,17 +71,21 @@ template <class T>
 class STDIndicesStream : public Stream<T>
 {
   protected:
-    // Size of arrays
-    int array_size;
+    // Size of arrays, and the number of elements actually allocated
+    intptr_t array_size;
+    intptr_t alloc_size;
 
     // induction range
-    ranged<int> range;
+    ranged<intptr_t> range;
 
     // Device side pointers
     T *a, *b, *c;
 
+    // Index array for gather and scatter, allocated by the first set_indices
+    int *indices = nullptr;
+
   public:
-    STDIndicesStream(const int, int) noexcept;
+    STDIndicesStream(const intptr_t, int) noexcept;
     ~STDIndicesStream();
 
     virtual void copy() override;
@@ -92,5 +97,15 @@ class STDIndicesStream : public Stream<T>
 
     virtual void init_arrays(T initA, T initB, T initC) override;
     virtual void read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
+
+    virtual bool set_active_size(const intptr_t n) override;
+
+    virtual bool set_indices(const std::vector<int>& indices) override;
+    virtual void gather() override;
+    virtual void scatter() override;
+
+    virtual bool verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                        double& errA, double& errB, double& errC) override;
+    virtual bool host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c) override;
 };
 
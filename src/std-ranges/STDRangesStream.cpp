@@ -12,8 +12,8 @@
 #endif
 
 template <class T>
-STDRangesStream<T>::STDRangesStream(const int ARRAY_SIZE, int device)
-noexcept : array_size{ARRAY_SIZE},
+STDRangesStream<T>::STDRangesStream(const intptr_t ARRAY_SIZE, int device)
+noexcept : array_size{ARRAY_SIZE}, alloc_size{ARRAY_SIZE},
   a(alloc_raw<T>(ARRAY_SIZE)), b(alloc_raw<T>(ARRAY_SIZE)), c(alloc_raw<T>(ARRAY_SIZE))
 {
     std::cout << "Backing storage typeid: " << typeid(a).name() << std::endl;
@@ -44,8 +44,8 @@ void STDRangesStream<T>::init_arrays(T initA, T initB, T initC)
 {
   std::for_each_n(
     exe_policy,
-    std::views::iota(0).begin(), array_size, // loop range
-    [&] (int i) {
+    std::views::iota(intptr_t{0}).begin(), array_size, // loop range
+    [&] (intptr_t i) {
       a[i] = initA;
       b[i] = initB;
       c[i] = initC;
@@ -62,13 +62,22 @@ void STDRangesStream<T>::read_arrays(std::vector<T>& h_a, std::vector<T>& h_b, s
     std::copy(c, c + array_size, h_c.begin());
 }
 
+template <class T>
+bool STDRangesStream<T>::set_active_size(const intptr_t n)
+{
+  if (n > alloc_size)
+    return false;
+  array_size = n;
+  return true;
+}
+
 template <class T>
 void STDRangesStream<T>::copy()
 {
   std::for_each_n(
     exe_policy,
-    std::views::iota(0).begin(), array_size,
-    [&] (int i) {
+    std::views::iota(intptr_t{0}).begin(), array_size,
+    [&] (intptr_t i) {
       c[i] = a[i];
     }
   );
@@ -81,8 +90,8 @@ void STDRangesStream<T>::mul()
 
   std::for_each_n(
     exe_policy,
-    std::views::iota(0).begin(), array_size,
-    [&] (int i) {
+    std::views::iota(intptr_t{0}).begin(), array_size,
+    [&] (intptr_t i) {
       b[i] = scalar * c[i];
     }
   );
@@ -93,8 +102,8 @@ void STDRangesStream<T>::add()
 {
   std::for_each_n(
     exe_policy,
-    std::views::iota(0).begin(), array_size,
-    [&] (int i) {
+    std::views::iota(intptr_t{0}).begin(), array_size,
+    [&] (intptr_t i) {
       c[i] = a[i] + b[i];
     }
   );
@@ -107,8 +116,8 @@ void STDRangesStream<T>::triad()
 
   std::for_each_n(
     exe_policy,
-    std::views::iota(0).begin(), array_size,
-    [&] (int i) {
+    std::views::iota(intptr_t{0}).begin(), array_size,
+    [&] (intptr_t i) {
       a[i] = b[i] + scalar * c[i];
     }
   );
@@ -121,8 +130,8 @@ void STDRangesStream<T>::nstream()
 
   std::for_each_n(
     exe_policy,
-    std::views::iota(0).begin(), array_size,
-    [&] (int i) {
+    std::views::iota(intptr_t{0}).begin(), array_size,
+    [&] (intptr_t i) {
       a[i] += b[i] + scalar * c[i];
     }
   );
@@ -138,6 +147,47 @@ T STDRangesStream<T>::dot()
       a, a + array_size, b, T{});
 }
 
+template <class T>
+bool STDRangesStream<T>::verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                                double& errA, double& errB, double& errC)
+{
+  if (stride == 1)
+  {
+    errA = std::transform_reduce(exe_policy, a, a + array_size, 0.0, std::plus<double>(), [=](T ai){ return std::fabs(ai - goldA); }) / array_size;
+    errB = std::transform_reduce(exe_policy, b, b + array_size, 0.0, std::plus<double>(), [=](T bi){ return std::fabs(bi - goldB); }) / array_size;
+    errC = std::transform_reduce(exe_policy, c, c + array_size, 0.0, std::plus<double>(), [=](T ci){ return std::fabs(ci - goldC); }) / array_size;
+    return true;
+  }
+
+  // A sample is small enough to check on the calling thread
+  double sumA = 0.0, sumB = 0.0, sumC = 0.0;
+  for (intptr_t i = 0; i < array_size; i += stride)
+  {
+    sumA += std::fabs(a[i] - goldA);
+    sumB += std::fabs(b[i] - goldB);
+    sumC += std::fabs(c[i] - goldC);
+  }
+  const intptr_t n = (array_size + stride - 1) / stride;
+  errA = sumA / n;
+  errB = sumB / n;
+  errC = sumC / n;
+  return true;
+}
+
+template <class T>
+bool STDRangesStream<T>::host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c)
+{
+#if defined(STD_HOST_ARRAYS)
+  a = {this->a, array_size};
+  b = {this->b, array_size};
+  c = {this->c, array_size};
+  return true;
+#else
+  // Shared memory that may be on the device; reading it from the host would migrate it
+  return false;
+#endif
+}
+
 void listDevices(void)
 {
   std::cout << "C++20 does not expose devices" << std::endl;
@@ -153,5 +203,16 @@ std::string getDeviceDriver(const int)
   return std::string("Device driver unavailable");
 }
 
+bool getDeviceMemory(const int, size_t& memory, size_t& cache)
+{
+#if defined(STD_HOST_ARRAYS)
+  return false;
+#else
+  // Neither oneDPL nor stdpar report the memory of the device
+  memory = cache = 0;
+  return true;
+#endif
+}
+
 template class STDRangesStream<float>;
 template class STDRangesStream<double>;
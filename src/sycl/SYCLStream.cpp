@@ -317,6 +317,24 @@ std::string getDeviceDriver(const int device)
   return driver;
 }
 
+bool getDeviceMemory(const int device, size_t& memory, size_t& cache)
+{
+  if (!cached)
+    getDeviceList();
+
+  if (device < devices.size())
+  {
+    memory = devices[device].get_info<info::device::global_mem_size>();
+    cache = devices[device].get_info<info::device::global_mem_cache_size>();
+  }
+  else
+  {
+    throw std::runtime_error("Error asking for memory of non-existant device");
+  }
+
+  return true;
+}
+
 // TODO: Fix kernel names to allow multiple template specializations
 template class SYCLStream<float>;
 template class SYCLStream<double>;
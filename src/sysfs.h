@@ -0,0 +1,152 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+// Helpers for the Linux /sys and /proc files describing the topology of the host
+
+// First line of a file, or an empty string if it cannot be read
+inline std::string read_sysfs_line(const std::string& path)
+{
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+// Parses a list such as "0-3,8,10-11" as used for CPU and node lists in sysfs.
+// Returns false if the list is malformed.
+inline bool parse_id_list(const std::string& list, std::vector<int>& ids)
+{
+  ids.clear();
+  std::stringstream ranges(list);
+  std::string range;
+  while (std::getline(ranges, range, ','))
+  {
+    if (range.empty())
+      continue;
+    char *end;
+    long first = strtol(range.c_str(), &end, 10);
+    long last = first;
+    if (*end == '-')
+      last = strtol(end + 1, &end, 10);
+    if (*end != '\0' || first < 0 || last < first)
+      return false;
+    for (long id = first; id <= last; id++)
+      ids.push_back(static_cast<int>(id));
+  }
+  return true;
+}
+
+// NUMA nodes of this host; a single node 0 if not known
+inline std::vector<int> online_numa_nodes()
+{
+  std::vector<int> nodes;
+  if (!parse_id_list(read_sysfs_line("/sys/devices/system/node/online"), nodes) || nodes.empty())
+    nodes = {0};
+  return nodes;
+}
+
+// Parses a size such as "32768K" as used for cache sizes in sysfs, or a plain number of bytes;
+// 0 if it is anything else
+inline size_t parse_sysfs_size(const std::string& text)
+{
+  char *end;
+  unsigned long long value = strtoull(text.c_str(), &end, 10);
+  if (end == text.c_str())
+    return 0;
+  switch (*end)
+  {
+    case '\0': return value;
+    case 'K':  return value << 10;
+    case 'M':  return value << 20;
+    case 'G':  return value << 30;
+    default:   return 0;
+  }
+}
+
+// Total size of the last-level data caches of the host, counting a cache shared by several
+// CPUs once, as the STREAM rules for the array size do; 0 if sysfs does not describe them
+inline size_t last_level_cache_bytes()
+{
+  std::vector<int> cpus;
+  if (!parse_id_list(read_sysfs_line("/sys/devices/system/cpu/online"), cpus))
+    return 0;
+
+  int last_level = 0;
+  size_t total = 0;
+  // A cache is identified by the CPUs sharing it
+  std::set<std::string> counted;
+  for (int cpu : cpus)
+  {
+    const std::string caches = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache/index";
+    for (int index = 0; ; index++)
+    {
+      const std::string cache = caches + std::to_string(index) + "/";
+      const std::string type = read_sysfs_line(cache + "type");
+      if (type.empty())
+        break;
+      const int level = atoi(read_sysfs_line(cache + "level").c_str());
+      if (type == "Instruction" || level < last_level)
+        continue;
+      if (level > last_level)
+      {
+        last_level = level;
+        total = 0;
+        counted.clear();
+      }
+      if (counted.insert(read_sysfs_line(cache + "shared_cpu_list")).second)
+        total += parse_sysfs_size(read_sysfs_line(cache + "size"));
+    }
+  }
+  return total;
+}
+
+// A field of a meminfo file, such as MemAvailable in /proc/meminfo or MemFree in that of a NUMA
+// node, in bytes; 0 if it is not there
+inline size_t read_meminfo(const std::string& path, const std::string& field)
+{
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line))
+  {
+    size_t at = line.find(field + ":");
+    if (at != std::string::npos)
+      return strtoull(line.c_str() + at + field.size() + 1, nullptr, 10) * 1024;
+  }
+  return 0;
+}
+
+// Bytes this process can allocate without running out: what the kernel reports as available,
+// or as free on the given NUMA nodes if any are given, within the limit of the memory cgroup of
+// the process (v2, else v1); 0 if not known
+inline size_t available_memory(const std::vector<int>& nodes = {})
+{
+  size_t available = 0;
+  if (nodes.empty())
+    available = read_meminfo("/proc/meminfo", "MemAvailable");
+  for (int node : nodes)
+    available += read_meminfo("/sys/devices/system/node/node" + std::to_string(node) + "/meminfo", "MemFree");
+
+  // An unlimited cgroup reads "max" in v2 and a huge number in v1
+  size_t limit = parse_sysfs_size(read_sysfs_line("/sys/fs/cgroup/memory.max"));
+  size_t used = parse_sysfs_size(read_sysfs_line("/sys/fs/cgroup/memory.current"));
+  if (limit == 0)
+  {
+    limit = parse_sysfs_size(read_sysfs_line("/sys/fs/cgroup/memory/memory.limit_in_bytes"));
+    used = parse_sysfs_size(read_sysfs_line("/sys/fs/cgroup/memory/memory.usage_in_bytes"));
+  }
+  if (limit > used && (available == 0 || limit - used < available))
+    available = limit - used;
+  return available;
+}
@@ -5,31 +5,31 @@
 // source code
 
 #include "TBBStream.hpp"
-#include <cstdlib>
+#include "host_alloc.h"
 
-#ifndef ALIGNMENT
-#define ALIGNMENT (2*1024*1024) // 2MB
-#endif
+#include <cmath>
 
 #ifdef USE_VECTOR
 #define BEGIN(x) (x).begin()
-#define END(x) (x).end()
+#define END(x) ((x).begin() + array_size)
 #else
 #define BEGIN(x) (x)
 #define END(x) ((x) + array_size)
 #endif
 
 template <class T>
-TBBStream<T>::TBBStream(const int ARRAY_SIZE, int device)
+TBBStream<T>::TBBStream(const intptr_t ARRAY_SIZE, int device)
  : partitioner(), range(0, ARRAY_SIZE),
+   array_size(ARRAY_SIZE), alloc_size(ARRAY_SIZE),
 #ifdef USE_VECTOR
-   a(ARRAY_SIZE), b(ARRAY_SIZE), c(ARRAY_SIZE)
+   a(ARRAY_SIZE), b(ARRAY_SIZE), c(ARRAY_SIZE),
 #else
-   array_size(ARRAY_SIZE),
-   a((T *) aligned_alloc(ALIGNMENT, sizeof(T) * ARRAY_SIZE)),
-   b((T *) aligned_alloc(ALIGNMENT, sizeof(T) * ARRAY_SIZE)),
-   c((T *) aligned_alloc(ALIGNMENT, sizeof(T) * ARRAY_SIZE))
+   a(host_alloc<T>(ARRAY_SIZE)),
+   b(host_alloc<T>(ARRAY_SIZE)),
+   c(host_alloc<T>(ARRAY_SIZE)),
+   indices(nullptr),
 #endif
+   instrumented(false)
 {
   if(device != 0){
     throw std::runtime_error("Device != 0 is not supported by TBB");
@@ -38,6 +38,18 @@ TBBStream<T>::TBBStream(const int ARRAY_SIZE, int device)
   std::cout << "Backing storage typeid: " << typeid(a).name() << std::endl;
 }
 
+template <class T>
+TBBStream<T>::~TBBStream()
+{
+#ifndef USE_VECTOR
+  host_free(a);
+  host_free(b);
+  host_free(c);
+  if (indices)
+    host_free(indices);
+#endif
+}
+
 
 template <class T>
 void TBBStream<T>::init_arrays(T initA, T initB, T initC)
@@ -62,13 +74,99 @@ void TBBStream<T>::read_arrays(std::vector<T>& h_a, std::vector<T>& h_b, std::ve
   std::copy(BEGIN(c), END(c), h_c.begin());
 }
 
+template <class T>
+bool TBBStream<T>::set_active_size(const intptr_t n)
+{
+  if (static_cast<size_t>(n) > alloc_size)
+    return false;
+  array_size = n;
+  range = tbb::blocked_range<size_t>(0, n);
+  return true;
+}
+
+template <class T>
+bool TBBStream<T>::set_instrumented(const bool enable)
+{
+  instrumented = enable;
+  return true;
+}
+
+template <class T>
+std::vector<ThreadTiming> TBBStream<T>::thread_timings()
+{
+  return thread_times;
+}
+
+template <class T>
+void TBBStream<T>::begin_timing()
+{
+  if (instrumented)
+    thread_times.assign(tbb::this_task_arena::max_concurrency(), ThreadTiming());
+}
+
+// A thread runs its chunks one after another, so its first chunk starts its share
+template <class T>
+void TBBStream<T>::chunk_end(uint64_t start, size_t elements)
+{
+  if (!instrumented)
+    return;
+  ThreadTiming& timing = thread_times[tbb::this_task_arena::current_thread_index()];
+  if (timing.elements == 0)
+    timing.start = start;
+  timing.end = timer_ticks();
+  timing.elements += elements;
+}
+
+template <class T>
+bool TBBStream<T>::set_indices(const std::vector<int>& h_indices)
+{
+  if (h_indices.size() > alloc_size)
+    return false;
+#ifdef USE_VECTOR
+  indices.resize(alloc_size);
+#else
+  if (!indices)
+    indices = host_alloc<int>(alloc_size);
+#endif
+
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, h_indices.size()), [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t i = r.begin(); i < r.end(); ++i) {
+      indices[i] = h_indices[i];
+    }
+  }, partitioner);
+  return true;
+}
+
+template <class T>
+void TBBStream<T>::gather()
+{
+  tbb::parallel_for(range, [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t i = r.begin(); i < r.end(); ++i) {
+       a[i] = b[indices[i]];
+    }
+  }, partitioner);
+}
+
+template <class T>
+void TBBStream<T>::scatter()
+{
+  tbb::parallel_for(range, [&](const tbb::blocked_range<size_t>& r) {
+    for (size_t i = r.begin(); i < r.end(); ++i) {
+       a[indices[i]] = b[i];
+    }
+  }, partitioner);
+}
+
 template <class T>
 void TBBStream<T>::copy()
 {
+  begin_timing();
   tbb::parallel_for(range, [&](const tbb::blocked_range<size_t>& r) {
+    const uint64_t start = chunk_start();
     for (size_t i = r.begin(); i < r.end(); ++i) {
        c[i] = a[i];
     }
+    chunk_end(start, r.size());
   }, partitioner);
 }
 
@@ -77,10 +175,13 @@ void TBBStream<T>::mul()
 {
   const T scalar = startScalar;
 
+  begin_timing();
   tbb::parallel_for(range, [&](const tbb::blocked_range<size_t>& r) {
+    const uint64_t start = chunk_start();
     for (size_t i = r.begin(); i < r.end(); ++i) {
        b[i] = scalar * c[i];
     }
+    chunk_end(start, r.size());
   }, partitioner);
 
 }
@@ -89,10 +190,13 @@ template <class T>
 void TBBStream<T>::add()
 {
 
+  begin_timing();
   tbb::parallel_for(range, [&](const tbb::blocked_range<size_t>& r) {
+    const uint64_t start = chunk_start();
     for (size_t i = r.begin(); i < r.end(); ++i) {
        c[i] = a[i] + b[i];
     }
+    chunk_end(start, r.size());
   }, partitioner);
 
 }
@@ -102,10 +206,13 @@ void TBBStream<T>::triad()
 {
   const T scalar = startScalar;
 
+  begin_timing();
   tbb::parallel_for(range, [&](const tbb::blocked_range<size_t>& r) {
+    const uint64_t start = chunk_start();
     for (size_t i = r.begin(); i < r.end(); ++i) {
        a[i] = b[i] + scalar * c[i];
     }
+    chunk_end(start, r.size());
   }, partitioner);
 
 }
@@ -127,15 +234,51 @@ template <class T>
 T TBBStream<T>::dot()
 {
   // sum += a[i] * b[i];
+  begin_timing();
   return
     tbb::parallel_reduce(range, T{}, [&](const tbb::blocked_range<size_t>& r, T acc) {
+      const uint64_t start = chunk_start();
       for (size_t i = r.begin(); i < r.end(); ++i) {
         acc += a[i] * b[i];
       }
+      chunk_end(start, r.size());
       return acc;
     }, std::plus<T>(), partitioner);
 }
 
+template <class T>
+bool TBBStream<T>::verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                          double& errA, double& errB, double& errC)
+{
+  typedef std::array<double, 3> Sums;
+  const size_t n = (array_size + stride - 1) / stride;
+  Sums sums = tbb::parallel_reduce(tbb::blocked_range<size_t>(0, n), Sums{}, [&](const tbb::blocked_range<size_t>& r, Sums acc) {
+      for (size_t k = r.begin(); k < r.end(); ++k) {
+        const size_t i = k * stride;
+        acc[0] += std::fabs(a[i] - goldA);
+        acc[1] += std::fabs(b[i] - goldB);
+        acc[2] += std::fabs(c[i] - goldC);
+      }
+      return acc;
+    }, [](Sums x, const Sums& y) {
+      return Sums{x[0] + y[0], x[1] + y[1], x[2] + y[2]};
+    }, partitioner);
+
+  errA = sums[0] / n;
+  errB = sums[1] / n;
+  errC = sums[2] / n;
+  return true;
+}
+
+template <class T>
+bool TBBStream<T>::host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c)
+{
+  a = {&this->a[0], static_cast<intptr_t>(array_size)};
+  b = {&this->b[0], static_cast<intptr_t>(array_size)};
+  c = {&this->c[0], static_cast<intptr_t>(array_size)};
+  return true;
+}
+
 void listDevices(void)
 {
    std::cout << "Listing devices is not supported by TBB" << std::endl;
@@ -151,6 +294,11 @@ std::string getDeviceDriver(const int)
   return std::string("Device driver unavailable");
 }
 
+bool getDeviceMemory(const int, size_t&, size_t&)
+{
+  return false;
+}
+
 template class TBBStream<float>;
 template class TBBStream<double>;
 
@@ -8,8 +8,10 @@
 
 #include <iostream>
 #include <vector>
+#include <array>
 #include "tbb/tbb.h"
 #include "Stream.h"
+#include "tsc.h"
 
 #define IMPLEMENTATION_STRING "TBB"
 
@@ -39,19 +41,30 @@ class TBBStream : public Stream<T>
   
     tbb_partitioner partitioner;
     tbb::blocked_range<size_t> range;
+    // Size of arrays, and the number of elements actually allocated
+    size_t array_size;
+    size_t alloc_size;
     // Device side pointers
 #ifdef USE_VECTOR
     std::vector<T> a, b, c;
+    std::vector<int> indices;
 #else
-    size_t array_size;
     T *a, *b, *c;
+    // Index array for gather and scatter, allocated by the first set_indices
+    int *indices;
 #endif
 
-
+    // Record what each thread of the arena does in copy, mul, add, triad and dot,
+    // one chunk of the range at a time
+    bool instrumented;
+    std::vector<ThreadTiming> thread_times;
+    void begin_timing();
+    uint64_t chunk_start() const { return instrumented ? timer_ticks() : 0; }
+    void chunk_end(uint64_t start, size_t elements);
 
   public:
-    TBBStream(const int, int);
-    ~TBBStream() = default;
+    TBBStream(const intptr_t, int);
+    ~TBBStream();
 
     virtual void copy() override;
     virtual void add() override;
@@ -63,5 +76,17 @@ class TBBStream : public Stream<T>
     virtual void init_arrays(T initA, T initB, T initC) override;
     virtual void read_arrays(std::vector<T>& a, std::vector<T>& b, std::vector<T>& c) override;
 
+    virtual bool set_active_size(const intptr_t n) override;
+    virtual bool set_instrumented(const bool enable) override;
+    virtual std::vector<ThreadTiming> thread_timings() override;
+
+    virtual bool set_indices(const std::vector<int>& indices) override;
+    virtual void gather() override;
+    virtual void scatter() override;
+
+    virtual bool verify(const T goldA, const T goldB, const T goldC, const intptr_t stride,
+                        double& errA, double& errB, double& errC) override;
+    virtual bool host_arrays(HostArray<T>& a, HostArray<T>& b, HostArray<T>& c) override;
+
 };
 
@@ -208,6 +208,20 @@ std::string getDeviceDriver(const int device)
   return std::to_string(driver);
 }
 
+bool getDeviceMemory(const int device, size_t& memory, size_t& cache)
+{
+  IMPL_FN__(SetDevice(device));
+  check_error();
+  size_t total;
+  IMPL_FN__(MemGetInfo(&memory, &total));
+  check_error();
+  IMPL_TYPE__(DeviceProp) props = {};
+  IMPL_FN__(GetDeviceProperties(&props, device));
+  check_error();
+  cache = props.l2CacheSize;
+  return true;
+}
+
 #undef IMPL_FN__
 #undef IMPL_TPE__
 
@@ -228,6 +242,11 @@ std::string getDeviceDriver(const int)
   return std::string("(device driver unavailable)");
 }
 
+bool getDeviceMemory(const int, size_t&, size_t&)
+{
+  return false;
+}
+
 #endif
 
 template class ThrustStream<float>;
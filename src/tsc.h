@@ -0,0 +1,64 @@
+// Copyright (c) 2015-23 Tom Deakin, Simon McIntosh-Smith, Wei-Chen (Tom) Lin
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// A fine-grained timer for kernels short enough that the resolution and call overhead of
+// std::chrono matter: the time stamp counter on x86 and the virtual counter on Arm, both of which
+// tick at a constant rate on current CPUs. Elsewhere it falls back to std::chrono::steady_clock.
+
+inline uint64_t timer_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t ticks;
+  asm volatile("isb; mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Ticks per second, measured against std::chrono::steady_clock the first time it is needed.
+// Arm publishes the frequency of its counter, so nothing is measured there.
+inline double timer_frequency()
+{
+  static const double frequency = []
+  {
+#if defined(__aarch64__)
+    uint64_t hz;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(hz));
+    return static_cast<double>(hz);
+#elif defined(__x86_64__) || defined(__i386__)
+    // Spin for 50 ms, which puts the error well below that of the timings
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t ticks1 = timer_ticks();
+    std::chrono::steady_clock::time_point t2;
+    do
+      t2 = std::chrono::steady_clock::now();
+    while (t2 - t1 < std::chrono::milliseconds(50));
+    uint64_t ticks2 = timer_ticks();
+    return (ticks2 - ticks1) / std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count();
+#else
+    return 1.0E9;
+#endif
+  }();
+  return frequency;
+}
+
+inline double timer_seconds(uint64_t ticks)
+{
+  return ticks / timer_frequency();
+}